@@ -0,0 +1,238 @@
+/*
+    MineBatch - Headless batch simulation of minesweeper games
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineBatch.
+
+    MineBatch is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineBatch is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineBatch.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mb_strategy.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+///Command line options
+struct Options
+{
+    int rows = 16;
+    int cols = 30;
+    unsigned int mines = 99;
+    std::uint64_t seed = 0;
+    std::uint64_t games = 1000;
+    unsigned int threads = 0;
+    std::string strategy = "probability";
+    bool json = false;
+    ///Whether a single game is played by its ID, given in \c seed
+    bool by_id = false;
+};
+
+///Results of a range of games
+struct Results
+{
+    std::uint64_t games = 0;
+    std::uint64_t wins = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t guesses = 0;
+
+    Results& operator+=(const Results& other)
+    {
+        games += other.games;
+        wins += other.wins;
+        moves += other.moves;
+        guesses += other.guesses;
+        return *this;
+    }
+};
+
+///Number of games played by one task
+const std::uint64_t games_per_task = 16;
+///Number of frontier components remembered for all games
+const std::size_t cache_size = 1 << 16;
+
+void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [options]\n"
+        "Plays seeded minesweeper games without user interaction and reports the results.\n"
+        "Game g is played with the layout SeededLayout::game_id(seed, g), the first move is in the\n"
+        "center and always opens an area.\n\n"
+        "  --rows N         Number of rows (default 16)\n"
+        "  --cols N         Number of columns (default 30)\n"
+        "  --mines N        Number of mines (default 99)\n"
+        "  --seed N         Seed of the first game (default 0)\n"
+        "  --games N        Number of games (default 1000)\n"
+        "  --id N           Play only the game with the layout ID N\n"
+        "  --threads N      Number of threads, 0 for all cores (default 0)\n"
+        "  --strategy NAME  " << Strategy::names() << " (default probability)\n"
+        "  --format FORMAT  csv|json (default csv)\n";
+}
+
+///Parses the command line into \c opt, returns \c false if it is invalid
+bool parse(int argc, char** argv, Options& opt)
+{
+    for(int a = 1; a < argc; ++a)
+    {
+        const std::string arg = argv[a];
+        if(arg == "--help" || arg == "-h" || a + 1 == argc)
+            return false;
+        const std::string val = argv[++a];
+        char* end = nullptr;
+        const unsigned long long num = std::strtoull(val.c_str(), &end, 10);
+        const bool is_num = !val.empty() && *end == '\0';
+        //The size, the number of mines and of threads are narrowed to int and unsigned int
+        const bool is_int = is_num && num <= INT_MAX;
+
+        if(arg == "--strategy")
+            opt.strategy = val;
+        else if(arg == "--format" && (val == "csv" || val == "json"))
+            opt.json = val == "json";
+        else if(!is_num)
+            return false;
+        else if(arg == "--rows" && is_int)
+            opt.rows = num;
+        else if(arg == "--cols" && is_int)
+            opt.cols = num;
+        else if(arg == "--mines" && is_int)
+            opt.mines = num;
+        else if(arg == "--seed")
+            opt.seed = num;
+        else if(arg == "--id")
+        {
+            opt.seed = num;
+            opt.games = 1;
+            opt.by_id = true;
+        }
+        else if(arg == "--games")
+            opt.games = num;
+        else if(arg == "--threads" && is_int)
+            opt.threads = num;
+        else
+            return false;
+    }
+    return opt.rows > 0 && opt.cols > 0;
+}
+
+///Plays the game with the layout ID \c id, sharing the probabilities of frontier components through \c cache
+Results play(const Options& opt, std::uint64_t id, ProbabilityEngine::Cache& cache)
+{
+    const int startr = opt.rows / 2, startc = opt.cols / 2;
+    Minesweeper ms(opt.rows, opt.cols);
+    SeededLayout(opt.rows, opt.cols, opt.mines, id, startr, startc, true).apply(ms);
+    CounterRng rng(id, 1);
+    std::unique_ptr<Strategy> strategy = Strategy::create(opt.strategy, ms, rng, &cache);
+
+    Results res;
+    res.games = 1;
+    std::vector<Minesweeper::Position> delta, moves;
+    ms.uncover(startr, startc, delta);
+    ++res.moves;
+    while(ms.running())
+    {
+        moves.clear();
+        if(!strategy->choose(delta, moves))
+            ++res.guesses;
+        delta.clear();
+        for(const Minesweeper::Position& p: moves)
+        {
+            if(!ms.running())
+                break;
+            ms.uncover(p.first, p.second, delta);
+            ++res.moves;
+        }
+    }
+    res.wins = ms.state() == Minesweeper::GameState::win;
+    return res;
+}
+
+void print(std::ostream& os, const Options& opt, const Results& res, double seconds, unsigned int threads)
+{
+    const double games = std::max<std::uint64_t>(res.games, 1);
+    os << std::setprecision(6);
+    if(opt.json)
+    {
+        os << "{\"rows\": " << opt.rows << ", \"cols\": " << opt.cols << ", \"mines\": " << opt.mines
+           << ", \"strategy\": \"" << opt.strategy << "\", \"seed\": " << opt.seed
+           << ", \"games\": " << res.games << ", \"wins\": " << res.wins
+           << ", \"win_rate\": " << res.wins / games << ", \"mean_moves\": " << res.moves / games
+           << ", \"mean_guesses\": " << res.guesses / games << ", \"seconds\": " << seconds
+           << ", \"games_per_second\": " << res.games / seconds << ", \"threads\": " << threads << "}\n";
+    }
+    else
+    {
+        os << "rows,cols,mines,strategy,seed,games,wins,win_rate,mean_moves,mean_guesses,seconds,games_per_second,threads\n"
+           << opt.rows << ',' << opt.cols << ',' << opt.mines << ',' << opt.strategy << ',' << opt.seed << ','
+           << res.games << ',' << res.wins << ',' << res.wins / games << ',' << res.moves / games << ','
+           << res.guesses / games << ',' << seconds << ',' << res.games / seconds << ',' << threads << '\n';
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if(!parse(argc, argv, opt))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        //Check the options before starting the threads
+        {
+            CounterRng rng(0);
+            Minesweeper ms(opt.rows, opt.cols);
+            SeededLayout(opt.rows, opt.cols, opt.mines, 0, opt.rows / 2, opt.cols / 2, true).apply(ms);
+            Strategy::create(opt.strategy, ms, rng);
+        }
+
+        ThreadPool pool(opt.threads);
+        const std::uint64_t tasks = (opt.games + games_per_task - 1) / games_per_task;
+        std::vector<Results> results(tasks);
+        ProbabilityEngine::Cache cache(cache_size);
+
+        const auto begin = std::chrono::steady_clock::now();
+        pool.run(tasks, [&](std::size_t t)
+        {
+            const std::uint64_t end = std::min(opt.games, (t + 1) * games_per_task);
+            for(std::uint64_t g = t * games_per_task; g < end; ++g)
+                results[t] += play(opt, opt.by_id ? opt.seed : SeededLayout::game_id(opt.seed, g), cache);
+        });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        Results total;
+        for(const Results& r: results)
+            total += r;
+        print(std::cout, opt, total, seconds, pool.size());
+    }
+    catch(std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
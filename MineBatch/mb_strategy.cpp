@@ -0,0 +1,103 @@
+/*
+    MineBatch - Headless batch simulation of minesweeper games
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineBatch.
+
+    MineBatch is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineBatch is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineBatch.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mb_strategy.h"
+#include "solver.h"
+
+#include <stdexcept>
+
+namespace
+{
+
+///Uncovers the cells the Solver finds safe and guesses a random covered cell when it is stuck
+class SolverStrategy: public Strategy
+{
+public:
+    SolverStrategy(const Minesweeper& ms, CounterRng& rng):
+        ms(ms), rng(rng), solver(ms)
+    {}
+
+    bool choose(const std::vector<Position>& delta, std::vector<Position>& moves) override
+    {
+        solver.update(delta);
+        if(solver.solve() && !solver.safe_cells().empty())
+        {
+            moves = solver.safe_cells();
+            return true;
+        }
+        moves.push_back(guess());
+        return false;
+    }
+
+protected:
+    const Minesweeper& ms;
+    CounterRng& rng;
+    Solver solver;
+
+    ///Returns a random covered cell which is not known to be a mine
+    virtual Position guess()
+    {
+        std::vector<Position> candidates;
+        for(int i = 0; i < ms.rows(); ++i)
+        for(int j = 0; j < ms.cols(); ++j)
+        {
+            if(!ms.cell(i, j).visible() && !solver.known_mine(i, j))
+                candidates.emplace_back(i, j);
+        }
+        return candidates[rng() % candidates.size()];
+    }
+};
+
+///Like SolverStrategy, but guesses the cell with the lowest mine probability
+class ProbabilityStrategy: public SolverStrategy
+{
+public:
+    ProbabilityStrategy(const Minesweeper& ms, CounterRng& rng, ProbabilityEngine::Cache* cache):
+        SolverStrategy(ms, rng), engine(ms, nullptr, cache)
+    {}
+
+protected:
+    ProbabilityEngine engine;
+
+    Position guess() override
+    {
+        if(!engine.compute())
+            return SolverStrategy::guess();
+        return engine.safest();
+    }
+};
+
+}
+
+std::unique_ptr<Strategy> Strategy::create(const std::string& name, const Minesweeper& ms, CounterRng& rng,
+                                           ProbabilityEngine::Cache* cache)
+{
+    if(name == "solver")
+        return std::unique_ptr<Strategy>(new SolverStrategy(ms, rng));
+    else if(name == "probability")
+        return std::unique_ptr<Strategy>(new ProbabilityStrategy(ms, rng, cache));
+    else
+        throw std::invalid_argument("Unknown strategy: " + name);
+}
+
+const char* Strategy::names()
+{
+    return "solver|probability";
+}
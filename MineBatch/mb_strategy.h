@@ -0,0 +1,63 @@
+/*
+    MineBatch - Headless batch simulation of minesweeper games
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineBatch.
+
+    MineBatch is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineBatch is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineBatch.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MB_STRATEGY_H_INCLUDED
+#define MB_STRATEGY_H_INCLUDED
+
+#include "minesweeper.h"
+#include "probability.h"
+#include "seeded_layout.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/** \brief A way of playing a game
+ *
+ * A strategy is created for one game and asked for its next moves until the game is over.
+ */
+class Strategy
+{
+public:
+    typedef Minesweeper::Position Position;
+
+    virtual ~Strategy() {}
+
+    /** \brief Chooses the cells to uncover next
+     * \param delta The cells uncovered since the last call
+     * \param moves Receives the cells to uncover, at least one
+     * \return \c true if the moves are certainly safe, \c false if they are a guess
+     */
+    virtual bool choose(const std::vector<Position>& delta, std::vector<Position>& moves) = 0;
+
+    /** \brief Creates the strategy called \c name for the game \c ms
+     * \param rng Source of randomness for guesses, which has to outlive the strategy
+     * \param cache Results shared with the strategies of other games, or \c nullptr.
+     * It has to outlive the strategy.
+     * \throw std::invalid_argument if there is no strategy called \c name
+     */
+    static std::unique_ptr<Strategy> create(const std::string& name, const Minesweeper& ms, CounterRng& rng,
+                                            ProbabilityEngine::Cache* cache = nullptr);
+
+    ///Returns the names of the available strategies, separated by '|'
+    static const char* names();
+};
+
+#endif
@@ -39,7 +39,7 @@ int MineCursesApp::run()
         if(!init_form())
             return 0;
 
-        ms = new Minesweeper(rows, cols);
+        ms = pool.acquire(rows, cols);
         msw = new NCursesWindow(rows+2, cols+2, std::max(0, (20-rows-2)/2), (80-cols-2)/2);
         msw->bkgd(' ' | COLOR_PAIR(15));
         msw->box();
@@ -129,7 +129,7 @@ void MineCursesApp::toggle_flag()
 {
     if(!ms->cell(ci, cj).visible())
     {
-        ms->cell(ci, cj).flag = !ms->cell(ci, cj).flag;
+        ms->toggle_flag(ci, cj);
         draw_cell();
         movec();
         msw->refresh();
@@ -143,9 +143,11 @@ bool MineCursesApp::make_move()
         std::mt19937 rng(std::time(nullptr));
         ms->rand_init(mines, rng, ci, cj);
     }
-    if(ms->click(ci, cj))
+    revealed.clear();
+    if(ms->click(ci, cj, revealed).uncovered > 0)
     {
-        draw_field();
+        for(const Minesweeper::Position& p: revealed)
+            draw_cell(p.first, p.second);
         movec();
         msw->refresh();
     }
@@ -234,7 +236,7 @@ void MineCursesApp::draw_cell(int i, int j)
     int ch;
     if(!ms->cell(i, j).visible())
     {
-        if(ms->cell(i, j).flag)
+        if(ms->cell(i, j).flag())
             ch = ' ' | COLOR_PAIR(11);
         else
             ch = ' ' | COLOR_PAIR(10);
@@ -276,7 +278,6 @@ void MineCursesApp::draw_field()
 MineCursesApp::~MineCursesApp()
 {
     delete msw;
-    delete ms;
 }
 
 static MineCursesApp mcapp;
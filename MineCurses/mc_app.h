@@ -23,9 +23,12 @@
 
 #include "mc_conf.h"
 #include "minesweeper.h"
+#include "minesweeper_pool.h"
 
 #include <cursesapp.h>
 
+#include <vector>
+
 class MineCursesApp : public NCursesApplication
 {
 public:
@@ -33,7 +36,7 @@ public:
         NCursesApplication(true),
         rt(nullptr),
         msw(nullptr),
-        ms(nullptr)
+        pool(1)
     {}
 
     ~MineCursesApp();
@@ -44,13 +47,18 @@ public:
 private:
     NCursesWindow* rt;
     NCursesWindow* msw;
-    Minesweeper* ms;
+    ///Has to outlive ms
+    MinesweeperPool pool;
+    MinesweeperPool::Handle ms;
 
     int rows, cols;
     unsigned int mines;
 
     int ci, cj;
 
+    ///Cells uncovered by the last move
+    std::vector<Minesweeper::Position> revealed;
+
     void init_colors();
 
     bool init_form();
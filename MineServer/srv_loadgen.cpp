@@ -0,0 +1,346 @@
+/*
+    MineServer - Multi-session minesweeper game server
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineServer.
+
+    MineServer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineServer is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineServer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+///Command line options
+struct Options
+{
+    std::string path;
+    int port = 7373;
+    unsigned int connections = 16;
+    std::uint64_t requests = 10000;
+    int rows = 16;
+    int cols = 30;
+    unsigned int mines = 99;
+    std::uint64_t seed = 0;
+    bool json = false;
+};
+
+///What a client has measured
+struct Results
+{
+    std::uint64_t requests = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t games = 0;
+    ///Latency of each request in microseconds
+    std::vector<double> latencies;
+};
+
+void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [options]\n"
+        "Plays random games on a mineserver over many connections at once and reports\n"
+        "the requests per second and the latency percentiles.\n\n"
+        "  --unix PATH        Connect to the Unix socket PATH\n"
+        "  --port N           Connect to 127.0.0.1:N unless --unix is given (default 7373)\n"
+        "  --connections N    Number of concurrent connections (default 16)\n"
+        "  --requests N       Number of requests per connection (default 10000)\n"
+        "  --rows N           Number of rows (default 16)\n"
+        "  --cols N           Number of columns (default 30)\n"
+        "  --mines N          Number of mines (default 99)\n"
+        "  --seed N           Seed of the games and moves (default 0)\n"
+        "  --format FORMAT    csv|json (default csv)\n";
+}
+
+///Parses the command line into \c opt, returns \c false if it is invalid
+bool parse(int argc, char** argv, Options& opt)
+{
+    for(int a = 1; a < argc; ++a)
+    {
+        const std::string arg = argv[a];
+        if(arg == "--help" || arg == "-h" || a + 1 == argc)
+            return false;
+        const std::string val = argv[++a];
+        char* end = nullptr;
+        const unsigned long long num = std::strtoull(val.c_str(), &end, 10);
+        const bool is_num = !val.empty() && *end == '\0';
+
+        if(arg == "--unix")
+            opt.path = val;
+        else if(arg == "--format" && (val == "csv" || val == "json"))
+            opt.json = val == "json";
+        else if(!is_num)
+            return false;
+        else if(arg == "--port" && num < 65536)
+            opt.port = num;
+        else if(arg == "--connections")
+            opt.connections = num;
+        else if(arg == "--requests")
+            opt.requests = num;
+        else if(arg == "--rows")
+            opt.rows = num;
+        else if(arg == "--cols")
+            opt.cols = num;
+        else if(arg == "--mines")
+            opt.mines = num;
+        else if(arg == "--seed")
+            opt.seed = num;
+        else
+            return false;
+    }
+    return opt.connections > 0 && opt.rows > 0 && opt.cols > 0;
+}
+
+///A blocking connection to the server
+class Client
+{
+public:
+    explicit Client(const Options& opt)
+    {
+        if(!opt.path.empty())
+        {
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof addr);
+            addr.sun_family = AF_UNIX;
+            std::strncpy(addr.sun_path, opt.path.c_str(), sizeof addr.sun_path - 1);
+            mFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if(mFd < 0 || ::connect(mFd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0)
+                throw std::runtime_error("Cannot connect to " + opt.path + ": " + std::strerror(errno));
+        }
+        else
+        {
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof addr);
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(opt.port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            mFd = ::socket(AF_INET, SOCK_STREAM, 0);
+            if(mFd < 0 || ::connect(mFd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0)
+                throw std::runtime_error("Cannot connect to port " + std::to_string(opt.port) + ": " + std::strerror(errno));
+            const int one = 1;
+            ::setsockopt(mFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        }
+    }
+
+    ~Client() { ::close(mFd); }
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    ///Sends \c request and waits for the response line
+    std::string ask(const std::string& request)
+    {
+        const std::string line = request + '\n';
+        for(std::size_t sent = 0; sent < line.size(); )
+        {
+            const ssize_t n = ::send(mFd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+            if(n <= 0)
+                throw std::runtime_error("The server has closed the connection");
+            sent += n;
+        }
+        std::size_t pos;
+        while((pos = mIn.find('\n')) == std::string::npos)
+        {
+            char buf[16384];
+            const ssize_t n = ::read(mFd, buf, sizeof buf);
+            if(n <= 0)
+                throw std::runtime_error("The server has closed the connection");
+            mIn.append(buf, n);
+        }
+        std::string response = mIn.substr(0, pos);
+        mIn.erase(0, pos + 1);
+        return response;
+    }
+
+private:
+    int mFd;
+    std::string mIn;
+};
+
+///Plays random games over one connection
+Results play(const Options& opt, unsigned int client)
+{
+    Results res;
+    res.latencies.reserve(opt.requests);
+    Client conn(opt);
+    std::mt19937_64 rng(opt.seed * 1000003 + client);
+    //Covered cells which have not been uncovered yet
+    std::vector<char> open(opt.rows * opt.cols);
+    std::vector<int> candidates;
+    bool running = false;
+    std::string request;
+
+    for(std::uint64_t r = 0; r < opt.requests; ++r)
+    {
+        if(!running)
+        {
+            request = "new " + std::to_string(opt.rows) + ' ' + std::to_string(opt.cols) + ' '
+                    + std::to_string(opt.mines) + ' ' + std::to_string(rng());
+            std::fill(open.begin(), open.end(), 0);
+            ++res.games;
+        }
+        else
+        {
+            //Uncover a random covered cell, or sometimes flag one
+            candidates.clear();
+            for(int n = 0; n < int(open.size()); ++n)
+            {
+                if(!open[n])
+                    candidates.push_back(n);
+            }
+            const int n = candidates[rng() % candidates.size()];
+            request = (rng() % 10 == 0 ? "flag " : "click ") + std::to_string(n / opt.cols) + ' ' + std::to_string(n % opt.cols);
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        const std::string response = conn.ask(request);
+        res.latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+        ++res.requests;
+
+        std::istringstream is(response);
+        std::string status, state;
+        is >> status >> state;
+        if(status != "ok")
+        {
+            ++res.errors;
+            running = false;
+            continue;
+        }
+        if(state == "new")
+        {
+            running = true;
+            continue;
+        }
+        running = state == "running" || state == "uninitialized";
+        if(request.compare(0, 5, "click") == 0)
+        {
+            std::size_t count;
+            is >> count;
+            for(std::size_t k = 0; k < count; ++k)
+            {
+                int i, j, a;
+                is >> i >> j >> a;
+                open[i * opt.cols + j] = 1;
+            }
+        }
+    }
+    return res;
+}
+
+///Returns the \c p quantile of the sorted values \c v
+double percentile(const std::vector<double>& v, double p)
+{
+    if(v.empty())
+        return 0;
+    return v[std::min(v.size() - 1, std::size_t(p * v.size()))];
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if(!parse(argc, argv, opt))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        std::vector<Results> results(opt.connections);
+        std::vector<std::exception_ptr> errors(opt.connections);
+        std::vector<std::thread> threads;
+        const auto begin = std::chrono::steady_clock::now();
+        for(unsigned int c = 0; c < opt.connections; ++c)
+        {
+            threads.emplace_back([&, c]()
+            {
+                try
+                {
+                    results[c] = play(opt, c);
+                }
+                catch(...)
+                {
+                    errors[c] = std::current_exception();
+                }
+            });
+        }
+        for(std::thread& t: threads)
+            t.join();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        for(const std::exception_ptr& e: errors)
+        {
+            if(e)
+                std::rethrow_exception(e);
+        }
+
+        Results total;
+        for(Results& r: results)
+        {
+            total.requests += r.requests;
+            total.errors += r.errors;
+            total.games += r.games;
+            total.latencies.insert(total.latencies.end(), r.latencies.begin(), r.latencies.end());
+        }
+        std::sort(total.latencies.begin(), total.latencies.end());
+        const double p50 = percentile(total.latencies, 0.5), p90 = percentile(total.latencies, 0.9),
+                     p99 = percentile(total.latencies, 0.99), p999 = percentile(total.latencies, 0.999),
+                     max = total.latencies.empty() ? 0 : total.latencies.back();
+
+        std::cout << std::setprecision(6);
+        if(opt.json)
+        {
+            std::cout << "{\"connections\": " << opt.connections << ", \"requests\": " << total.requests
+                      << ", \"errors\": " << total.errors << ", \"games\": " << total.games
+                      << ", \"seconds\": " << seconds << ", \"requests_per_second\": " << total.requests / seconds
+                      << ", \"p50_us\": " << p50 << ", \"p90_us\": " << p90 << ", \"p99_us\": " << p99
+                      << ", \"p999_us\": " << p999 << ", \"max_us\": " << max << "}\n";
+        }
+        else
+        {
+            std::cout << "connections,requests,errors,games,seconds,requests_per_second,p50_us,p90_us,p99_us,p999_us,max_us\n"
+                      << opt.connections << ',' << total.requests << ',' << total.errors << ',' << total.games << ','
+                      << seconds << ',' << total.requests / seconds << ',' << p50 << ',' << p90 << ','
+                      << p99 << ',' << p999 << ',' << max << '\n';
+        }
+    }
+    catch(std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+    MineServer - Multi-session minesweeper game server
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineServer.
+
+    MineServer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineServer is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineServer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "srv_server.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+///Command line options
+struct Options
+{
+    std::string path;
+    int port = 7373;
+    unsigned int threads = 0;
+};
+
+Server* running_server = nullptr;
+
+extern "C" void on_signal(int)
+{
+    if(running_server)
+        running_server->stop();
+}
+
+void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [options]\n"
+        "Serves minesweeper games to many clients with a line based protocol:\n"
+        "  new ROWS COLS MINES [SEED], click I J, chord I J, flag I J, state\n"
+        "See the README for the responses.\n\n"
+        "  --unix PATH      Listen on the Unix socket PATH\n"
+        "  --port N         Listen on 127.0.0.1:N unless --unix is given (default 7373)\n"
+        "  --threads N      Number of worker threads, 0 for all cores (default 0)\n";
+}
+
+///Parses the command line into \c opt, returns \c false if it is invalid
+bool parse(int argc, char** argv, Options& opt)
+{
+    for(int a = 1; a < argc; ++a)
+    {
+        const std::string arg = argv[a];
+        if(arg == "--help" || arg == "-h" || a + 1 == argc)
+            return false;
+        const std::string val = argv[++a];
+        char* end = nullptr;
+        const unsigned long num = std::strtoul(val.c_str(), &end, 10);
+        const bool is_num = !val.empty() && *end == '\0';
+
+        if(arg == "--unix")
+            opt.path = val;
+        else if(!is_num)
+            return false;
+        else if(arg == "--port" && num < 65536)
+            opt.port = num;
+        else if(arg == "--threads")
+            opt.threads = num;
+        else
+            return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if(!parse(argc, argv, opt))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        Server server(opt.path, opt.port, opt.threads);
+        running_server = &server;
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        std::cerr << "Listening on " << (opt.path.empty() ? "127.0.0.1:" + std::to_string(opt.port) : opt.path) << std::endl;
+        server.run();
+        running_server = nullptr;
+    }
+    catch(std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,414 @@
+/*
+    MineServer - Multi-session minesweeper game server
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineServer.
+
+    MineServer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineServer is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineServer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "srv_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+///Longest accepted request line
+const std::size_t max_line = 4096;
+///Number of events taken from epoll at once
+const int max_events = 256;
+
+void check(bool ok, const char* what)
+{
+    if(!ok)
+        throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+}
+
+void set_nonblocking(int fd)
+{
+    check(::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) == 0, "fcntl");
+}
+
+}
+
+Server::Server(const std::string& path, int port, unsigned int workers):
+    mListen(-1),
+    mEpoll(-1),
+    mWake(-1),
+    mPath(path),
+    mStop(false),
+    mPool(1024),
+    mWorkersDone(false)
+{
+    if(!path.empty())
+    {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof addr);
+        addr.sun_family = AF_UNIX;
+        if(path.size() >= sizeof addr.sun_path)
+            throw std::runtime_error("The socket path is too long");
+        std::strcpy(addr.sun_path, path.c_str());
+        ::unlink(path.c_str());
+        mListen = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        check(mListen >= 0, "socket");
+        check(::bind(mListen, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0, "bind");
+    }
+    else
+    {
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        mListen = ::socket(AF_INET, SOCK_STREAM, 0);
+        check(mListen >= 0, "socket");
+        const int one = 1;
+        ::setsockopt(mListen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+        check(::bind(mListen, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0, "bind");
+    }
+    check(::listen(mListen, SOMAXCONN) == 0, "listen");
+    set_nonblocking(mListen);
+
+    mEpoll = ::epoll_create1(0);
+    check(mEpoll >= 0, "epoll_create1");
+    mWake = ::eventfd(0, EFD_NONBLOCK);
+    check(mWake >= 0, "eventfd");
+    for(int fd: {mListen, mWake})
+    {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        check(::epoll_ctl(mEpoll, EPOLL_CTL_ADD, fd, &ev) == 0, "epoll_ctl");
+    }
+
+    if(workers == 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned int t = 0; t < workers; ++t)
+        mWorkers.emplace_back(&Server::p_worker, this);
+}
+
+Server::~Server()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWorkLock);
+        mWorkersDone = true;
+    }
+    mWork.notify_all();
+    for(std::thread& t: mWorkers)
+        t.join();
+    for(auto& c: mConnections)
+        ::close(c.first);
+    mConnections.clear();
+    ::close(mWake);
+    ::close(mEpoll);
+    ::close(mListen);
+    if(!mPath.empty())
+        ::unlink(mPath.c_str());
+}
+
+void Server::run()
+{
+    epoll_event events[max_events];
+    while(!mStop)
+    {
+        const int n = ::epoll_wait(mEpoll, events, max_events, -1);
+        if(n < 0 && errno == EINTR)
+            continue;
+        check(n >= 0, "epoll_wait");
+        for(int k = 0; k < n; ++k)
+        {
+            const int fd = events[k].data.fd;
+            if(fd == mListen)
+                p_accept();
+            else if(fd == mWake)
+                p_collect();
+            else
+            {
+                auto it = mConnections.find(fd);
+                if(it == mConnections.end())
+                    continue;
+                const ConnectionPtr c = it->second;
+                if(events[k].events & (EPOLLERR | EPOLLHUP))
+                    p_close(c);
+                else
+                {
+                    if(events[k].events & EPOLLOUT)
+                        p_flush(c);
+                    if(events[k].events & EPOLLIN && !c->closed)
+                        p_read(c);
+                }
+            }
+        }
+    }
+}
+
+void Server::stop()
+{
+    mStop = true;
+    const std::uint64_t one = 1;
+    //Only async-signal-safe calls here
+    if(::write(mWake, &one, sizeof one) < 0)
+        return;
+}
+
+void Server::p_accept()
+{
+    while(true)
+    {
+        const int fd = ::accept(mListen, nullptr, nullptr);
+        if(fd < 0)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+            //EAGAIN, or out of descriptors: try again on the next event
+            return;
+        }
+        set_nonblocking(fd);
+        if(mPath.empty())
+        {
+            const int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        }
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if(::epoll_ctl(mEpoll, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            ::close(fd);
+            continue;
+        }
+        mConnections.emplace(fd, std::make_shared<Connection>(fd, mPool));
+    }
+}
+
+void Server::p_read(const ConnectionPtr& c)
+{
+    char buf[16384];
+    std::size_t old_size = c->in.size();
+    while(true)
+    {
+        const ssize_t n = ::read(c->fd, buf, sizeof buf);
+        if(n > 0)
+        {
+            c->in.append(buf, n);
+            continue;
+        }
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n == 0)
+        {
+            //The client will not send more, but still waits for the responses
+            c->half_closed = true;
+            epoll_event ev;
+            ev.events = 0;
+            if(c->writing)
+                ev.events |= EPOLLOUT;
+            ev.data.fd = c->fd;
+            ::epoll_ctl(mEpoll, EPOLL_CTL_MOD, c->fd, &ev);
+            break;
+        }
+        if(errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            p_close(c);
+            return;
+        }
+        break;
+    }
+
+    //Hand the complete lines to the workers
+    std::vector<std::string> lines;
+    std::size_t begin = 0;
+    for(std::size_t pos = c->in.find('\n', old_size); pos != std::string::npos; pos = c->in.find('\n', begin))
+    {
+        lines.emplace_back(c->in, begin, pos - begin);
+        begin = pos + 1;
+    }
+    c->in.erase(0, begin);
+    if(c->in.size() > max_line)
+    {
+        p_close(c);
+        return;
+    }
+    if(lines.empty())
+    {
+        if(c->half_closed)
+            p_close_if_done(c);
+        return;
+    }
+
+    bool schedule;
+    {
+        std::lock_guard<std::mutex> lock(c->lock);
+        for(std::string& l: lines)
+            c->requests.push_back(std::move(l));
+        schedule = !c->scheduled;
+        c->scheduled = true;
+    }
+    if(schedule)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mWorkLock);
+            mWorkQueue.push_back(c);
+        }
+        mWork.notify_one();
+    }
+}
+
+void Server::p_flush(const ConnectionPtr& c)
+{
+    std::size_t sent = 0;
+    while(sent < c->out.size())
+    {
+        const ssize_t n = ::send(c->fd, c->out.data() + sent, c->out.size() - sent, MSG_NOSIGNAL);
+        if(n > 0)
+            sent += n;
+        else if(n < 0 && errno == EINTR)
+            continue;
+        else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        else
+        {
+            p_close(c);
+            return;
+        }
+    }
+    c->out.erase(0, sent);
+
+    //Wait for the socket to become writable only while there is something left
+    const bool writing = !c->out.empty();
+    if(writing != c->writing)
+    {
+        epoll_event ev;
+        ev.events = 0;
+        if(!c->half_closed)
+            ev.events |= EPOLLIN;
+        if(writing)
+            ev.events |= EPOLLOUT;
+        ev.data.fd = c->fd;
+        ::epoll_ctl(mEpoll, EPOLL_CTL_MOD, c->fd, &ev);
+        c->writing = writing;
+    }
+    if(c->half_closed)
+        p_close_if_done(c);
+}
+
+void Server::p_close(const ConnectionPtr& c)
+{
+    if(c->closed.exchange(true))
+        return;
+    ::epoll_ctl(mEpoll, EPOLL_CTL_DEL, c->fd, nullptr);
+    ::close(c->fd);
+    mConnections.erase(c->fd);
+}
+
+void Server::p_close_if_done(const ConnectionPtr& c)
+{
+    if(!c->out.empty())
+        return;
+    bool done;
+    {
+        //A worker appends its responses before it clears scheduled
+        std::lock_guard<std::mutex> lock(c->lock);
+        done = c->requests.empty() && c->responses.empty() && !c->scheduled;
+    }
+    if(done)
+        p_close(c);
+}
+
+void Server::p_collect()
+{
+    std::uint64_t count;
+    if(::read(mWake, &count, sizeof count) < 0)
+        return;
+    std::vector<ConnectionPtr> ready;
+    {
+        std::lock_guard<std::mutex> lock(mReadyLock);
+        ready.swap(mReady);
+    }
+    for(const ConnectionPtr& c: ready)
+    {
+        if(c->closed)
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(c->lock);
+            c->out += c->responses;
+            c->responses.clear();
+        }
+        p_flush(c);
+    }
+}
+
+void Server::p_worker()
+{
+    std::string out;
+    while(true)
+    {
+        ConnectionPtr c;
+        {
+            std::unique_lock<std::mutex> lock(mWorkLock);
+            mWork.wait(lock, [this]() { return mWorkersDone || !mWorkQueue.empty(); });
+            if(mWorkersDone)
+                return;
+            c = std::move(mWorkQueue.front());
+            mWorkQueue.pop_front();
+        }
+
+        //Answer the requests of the connection until there are no more
+        std::deque<std::string> requests;
+        while(true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(c->lock);
+                c->responses += out;
+                if(c->requests.empty())
+                {
+                    c->scheduled = false;
+                    break;
+                }
+                requests.swap(c->requests);
+            }
+            out.clear();
+            for(const std::string& r: requests)
+            {
+                if(!c->closed)
+                    c->session.handle(r, out);
+            }
+            requests.clear();
+        }
+        out.clear();
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mReadyLock);
+            wake = mReady.empty();
+            mReady.push_back(std::move(c));
+        }
+        const std::uint64_t one = 1;
+        if(wake && ::write(mWake, &one, sizeof one) < 0)
+            continue;
+    }
+}
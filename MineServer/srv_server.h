@@ -0,0 +1,123 @@
+/*
+    MineServer - Multi-session minesweeper game server
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineServer.
+
+    MineServer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineServer is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineServer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SRV_SERVER_H_INCLUDED
+#define SRV_SERVER_H_INCLUDED
+
+#include "minesweeper_pool.h"
+#include "srv_session.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/** \brief Serves sessions over a Unix or loopback TCP socket
+ *
+ * One thread runs an epoll loop which accepts connections, reads requests and writes
+ * responses. Complete request lines are handed to a pool of workers, which run the
+ * Session of the connection and hand the responses back to the loop through an eventfd.
+ * A connection is handled by at most one worker at a time, so its requests are answered
+ * in order, and clients may send several requests without waiting for the responses.
+ */
+class Server
+{
+public:
+    /** \brief Listens on the Unix socket \c path if it is not empty, or else on 127.0.0.1:\c port
+     * \param workers Number of worker threads, 0 for one per hardware thread
+     * \throw std::runtime_error if the socket cannot be set up
+     */
+    Server(const std::string& path, int port, unsigned int workers);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    ///Serves until stop() is called
+    void run();
+
+    ///Makes run() return. Can be called from any thread and from signal handlers.
+    void stop();
+
+private:
+    ///A client and its session
+    struct Connection
+    {
+        explicit Connection(int fd, MinesweeperPool& pool): fd(fd), session(pool) {}
+
+        int fd;
+        ///Received bytes which do not form a complete line yet. Only used by the loop.
+        std::string in;
+        ///Bytes to be sent. Only used by the loop.
+        std::string out;
+        Session session;
+
+        std::mutex lock;
+        ///Requests waiting for a worker
+        std::deque<std::string> requests;
+        ///Responses made by a worker, waiting for the loop
+        std::string responses;
+        ///Whether the connection is queued for or handled by a worker
+        bool scheduled = false;
+        ///Whether the loop is waiting for the socket to become writable
+        bool writing = false;
+        ///Whether the client has shut down its side. The connection is closed once all its
+        ///requests are answered and sent. Only used by the loop.
+        bool half_closed = false;
+        std::atomic<bool> closed{false};
+    };
+    typedef std::shared_ptr<Connection> ConnectionPtr;
+
+    int mListen;
+    int mEpoll;
+    ///Wakes the loop when responses are ready or when stopping
+    int mWake;
+    std::string mPath;
+    std::atomic<bool> mStop;
+    MinesweeperPool mPool;
+    std::unordered_map<int, ConnectionPtr> mConnections;
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mWorkLock;
+    std::condition_variable mWork;
+    std::deque<ConnectionPtr> mWorkQueue;
+    bool mWorkersDone;
+
+    std::mutex mReadyLock;
+    ///Connections with responses for the loop to send
+    std::vector<ConnectionPtr> mReady;
+
+    void p_accept();
+    void p_read(const ConnectionPtr& c);
+    void p_flush(const ConnectionPtr& c);
+    void p_close(const ConnectionPtr& c);
+    ///Closes the half closed connection \c c if nothing is left to answer or send
+    void p_close_if_done(const ConnectionPtr& c);
+    void p_collect();
+    void p_worker();
+};
+
+#endif
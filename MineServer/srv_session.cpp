@@ -0,0 +1,212 @@
+/*
+    MineServer - Multi-session minesweeper game server
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineServer.
+
+    MineServer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineServer is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineServer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "srv_session.h"
+#include "seeded_layout.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+
+const char* state_name(Minesweeper::GameState state)
+{
+    switch(state)
+    {
+    case Minesweeper::GameState::uninitialized:
+        return "uninitialized";
+    case Minesweeper::GameState::running:
+        return "running";
+    case Minesweeper::GameState::win:
+        return "win";
+    default:
+        return "loss";
+    }
+}
+
+///Splits \c line at spaces
+void split(const std::string& line, std::vector<std::string>& words)
+{
+    words.clear();
+    std::size_t pos = 0;
+    while(pos < line.size())
+    {
+        const std::size_t end = std::min(line.find(' ', pos), line.size());
+        if(end > pos)
+            words.push_back(line.substr(pos, end - pos));
+        pos = end + 1;
+    }
+}
+
+///Parses a non-negative number, returns \c false if \c word is none
+bool parse(const std::string& word, std::uint64_t& num)
+{
+    char* end = nullptr;
+    num = std::strtoull(word.c_str(), &end, 10);
+    return !word.empty() && word[0] != '-' && *end == '\0';
+}
+
+}
+
+Session::Session(MinesweeperPool& pool):
+    mPool(pool),
+    mMines(0),
+    mSeed(0)
+{}
+
+void Session::handle(const std::string& line, std::string& out)
+{
+    thread_local std::vector<std::string> args;
+    split(!line.empty() && line.back() == '\r' ? line.substr(0, line.size() - 1) : line, args);
+    if(args.empty())
+    {
+        out += "err empty request\n";
+        return;
+    }
+
+    const std::string& cmd = args[0];
+    if(cmd == "new")
+        return p_new(args, out);
+    if(!mGame)
+    {
+        out += "err no game, send new first\n";
+        return;
+    }
+    if(cmd == "state")
+    {
+        if(args.size() != 1)
+        {
+            out += "err usage: state\n";
+            return;
+        }
+        out += "ok ";
+        out += state_name(mGame->state());
+        out += ' ' + std::to_string(mGame->state() == Minesweeper::GameState::uninitialized
+                                    ? mGame->cells() - mMines : mGame->covered())
+             + ' ' + std::to_string(mGame->rows()) + ' ' + std::to_string(mGame->cols()) + '\n';
+        return;
+    }
+    if(cmd != "click" && cmd != "chord" && cmd != "flag")
+    {
+        out += "err unknown command " + cmd + '\n';
+        return;
+    }
+    std::uint64_t i, j;
+    if(args.size() != 3 || !parse(args[1], i) || !parse(args[2], j))
+    {
+        out += "err usage: " + cmd + " I J\n";
+        return;
+    }
+    if(!mGame->in_range(int(std::min<std::uint64_t>(i, max_size)), int(std::min<std::uint64_t>(j, max_size))))
+    {
+        out += "err out of range\n";
+        return;
+    }
+    p_move(cmd, i, j, out);
+}
+
+void Session::p_new(const std::vector<std::string>& args, std::string& out)
+{
+    std::uint64_t rows, cols, mines, seed;
+    if((args.size() != 4 && args.size() != 5) || !parse(args[1], rows) || !parse(args[2], cols) || !parse(args[3], mines))
+    {
+        out += "err usage: new ROWS COLS MINES [SEED]\n";
+        return;
+    }
+    if(args.size() == 5)
+    {
+        if(!parse(args[4], seed))
+        {
+            out += "err usage: new ROWS COLS MINES [SEED]\n";
+            return;
+        }
+    }
+    else
+    {
+        thread_local std::mt19937_64 rng(std::random_device{}());
+        seed = rng();
+    }
+    if(rows < 1 || cols < 1 || rows > max_size || cols > max_size)
+    {
+        out += "err the size must be between 1 and " + std::to_string(max_size) + '\n';
+        return;
+    }
+    //The first click and its neighbors are kept free
+    if(rows*cols < 9 || mines > rows*cols - 9)
+    {
+        out += "err too many mines\n";
+        return;
+    }
+    mGame.reset();
+    mGame = mPool.acquire(rows, cols);
+    mMines = mines;
+    mSeed = seed;
+    out += "ok new " + std::to_string(rows) + ' ' + std::to_string(cols) + ' ' + std::to_string(mines)
+         + ' ' + std::to_string(seed) + '\n';
+}
+
+void Session::p_move(const std::string& cmd, int i, int j, std::string& out)
+{
+    Minesweeper& ms = *mGame;
+    if(cmd == "flag")
+    {
+        if(ms.cell(i, j).visible())
+        {
+            out += "err the cell is uncovered\n";
+            return;
+        }
+        if(ms.running())
+            ms.toggle_flag(i, j);
+        out += "ok ";
+        out += state_name(ms.state());
+        out += ms.cell(i, j).flag() ? " 1\n" : " 0\n";
+        return;
+    }
+
+    if(ms.state() == Minesweeper::GameState::uninitialized)
+    {
+        if(cmd != "click")
+        {
+            out += "err the first move has to be a click\n";
+            return;
+        }
+        SeededLayout(ms.rows(), ms.cols(), mMines, mSeed, i, j, true).apply(ms);
+    }
+
+    mDelta.clear();
+    if(ms.running())
+    {
+        if(cmd == "click")
+            ms.click(i, j, mDelta);
+        else
+            ms.chord(i, j, mDelta);
+    }
+    out += "ok ";
+    out += state_name(ms.state());
+    out += ' ' + std::to_string(mDelta.size());
+    for(const Minesweeper::Position& p: mDelta)
+    {
+        out += ' ' + std::to_string(p.first) + ' ' + std::to_string(p.second)
+             + ' ' + std::to_string(ms.cell(p.first, p.second).adjacents());
+    }
+    out += '\n';
+}
@@ -0,0 +1,68 @@
+/*
+    MineServer - Multi-session minesweeper game server
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of MineServer.
+
+    MineServer is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    MineServer is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with MineServer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SRV_SESSION_H_INCLUDED
+#define SRV_SESSION_H_INCLUDED
+
+#include "minesweeper_pool.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** \brief The game of one client and the line protocol to play it
+ *
+ * Each request is one line, answered by exactly one line:
+ * \code
+ * new ROWS COLS MINES [SEED]  ->  ok new ROWS COLS MINES SEED
+ * click I J                   ->  ok STATE COUNT [I J N]...
+ * chord I J                   ->  ok STATE COUNT [I J N]...
+ * flag I J                    ->  ok STATE FLAGGED
+ * state                       ->  ok STATE COVERED ROWS COLS
+ * \endcode
+ * click and chord report only the cells they have uncovered, with their numbers.
+ * STATE is one of uninitialized, running, win and loss. Errors are answered with
+ * "err " and a message. The mines are placed by SeededLayout on the first click,
+ * which always opens an area.
+ */
+class Session
+{
+public:
+    ///Largest number of rows and columns of a game
+    static const int max_size = 1024;
+
+    ///Creates a session without a game, which takes its games from \c pool
+    explicit Session(MinesweeperPool& pool);
+
+    ///Handles the request \c line, without the line break, and appends the response to \c out
+    void handle(const std::string& line, std::string& out);
+
+private:
+    MinesweeperPool& mPool;
+    MinesweeperPool::Handle mGame;
+    unsigned int mMines;
+    std::uint64_t mSeed;
+    std::vector<Minesweeper::Position> mDelta;
+
+    void p_new(const std::vector<std::string>& args, std::string& out);
+    void p_move(const std::string& cmd, int i, int j, std::string& out);
+};
+
+#endif
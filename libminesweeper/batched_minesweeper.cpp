@@ -0,0 +1,287 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "batched_minesweeper.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace
+{
+
+///Number of the lowest set bit
+inline int lowest_bit(std::uint64_t w)
+{
+    return std::bitset<64>((w & -w) - 1).count();
+}
+
+}
+
+BatchedMinesweeper::BatchedMinesweeper(std::size_t games, int rows, int cols):
+    mGames(games),
+    mRows(rows),
+    mCols(cols),
+    mStride(cols+2),
+    mGroups((games + word_bits - 1) / word_bits),
+    mState(games, GameState::uninitialized),
+    mCovered(games, 0),
+    mMineCount(games, 0),
+    mUncovered(games, 0)
+{
+    if(rows <= 0 || cols <= 0)
+        throw std::out_of_range("The number of rows and columns must be positive");
+    const std::size_t words = std::size_t(rows+2)*mStride*mGroups;
+    mMines.assign(words, 0);
+    mVisible.assign(words, ~Word(0));
+    mFlags.assign(words, 0);
+    mZero.assign(words, 0);
+    for(std::vector<Word>& a: mAdjacents)
+        a.assign(words, 0);
+    mPending.assign(words, 0);
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+        std::fill_n(&mVisible[index(i, j)*mGroups], mGroups, 0);
+
+    const int offsets[8] = { -mStride, -mStride-1, -mStride+1, mStride, mStride-1, mStride+1, -1, 1 };
+    std::copy(offsets, offsets+8, mNbOffsets);
+}
+
+void BatchedMinesweeper::init(std::size_t g)
+{
+    p_count(g / word_bits);
+    unsigned int mines = 0;
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+        mines += p_mine(g, i, j);
+    mMineCount[g] = mines;
+    mCovered[g] = cells() - mines;
+    mState[g] = GameState::running;
+}
+
+void BatchedMinesweeper::init()
+{
+    for(std::size_t w = 0; w < mGroups; ++w)
+        p_count(w);
+    std::fill(mMineCount.begin(), mMineCount.end(), 0);
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        const Word* mines = &mMines[index(i, j)*mGroups];
+        for(std::size_t w = 0; w < mGroups; ++w)
+        {
+            for(Word bits = mines[w]; bits; bits &= bits - 1)
+                ++mMineCount[w*word_bits + lowest_bit(bits)];
+        }
+    }
+    for(std::size_t g = 0; g < mGames; ++g)
+    {
+        mCovered[g] = cells() - mMineCount[g];
+        mState[g] = GameState::running;
+    }
+}
+
+void BatchedMinesweeper::p_count(std::size_t w)
+{
+    auto maj = [](Word a, Word b, Word c) { return (a & b) | (c & (a | b)); };
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        const std::size_t n = index(i, j);
+        Word nb[8];
+        for(int k = 0; k < 8; ++k)
+            nb[k] = mMines[(n + mNbOffsets[k])*mGroups + w];
+
+        //Carry-save addition of the eight one bit inputs, as in BitPlane::count_adjacents()
+        const Word s0 = nb[0] ^ nb[1] ^ nb[2], c0 = maj(nb[0], nb[1], nb[2]);
+        const Word s1 = nb[3] ^ nb[4] ^ nb[5], c1 = maj(nb[3], nb[4], nb[5]);
+        const Word s2 = nb[6] ^ nb[7], c2 = nb[6] & nb[7];
+        const Word carry = maj(s0, s1, s2);
+        const Word twos = c0 ^ c1 ^ c2, fours = maj(c0, c1, c2);
+        const Word fours2 = twos & carry;
+
+        const std::size_t x = n*mGroups + w;
+        mAdjacents[0][x] = s0 ^ s1 ^ s2;
+        mAdjacents[1][x] = twos ^ carry;
+        mAdjacents[2][x] = fours ^ fours2;
+        mAdjacents[3][x] = fours & fours2;
+        mZero[x] = ~(mAdjacents[0][x] | mAdjacents[1][x] | mAdjacents[2][x] | mAdjacents[3][x] | mMines[x]);
+    }
+}
+
+int BatchedMinesweeper::p_adjacents(std::size_t g, int i, int j) const
+{
+    const int n = index(i, j);
+    return p_get(mAdjacents[0], g, n) | p_get(mAdjacents[1], g, n) << 1
+         | p_get(mAdjacents[2], g, n) << 2 | p_get(mAdjacents[3], g, n) << 3;
+}
+
+void BatchedMinesweeper::p_set_mine(std::size_t g, int i, int j, bool mine)
+{
+    Word& w = mMines[index(i, j)*mGroups + g / word_bits];
+    const Word bit = Word(1) << (g % word_bits);
+    w = mine ? w | bit : w & ~bit;
+}
+
+void BatchedMinesweeper::step(const std::vector<Move>& moves, std::vector<Result>& results)
+{
+    if(moves.size() != mGames)
+        throw std::invalid_argument("There has to be one move per game");
+
+    for(std::size_t g = 0; g < mGames; ++g)
+    {
+        const Move& m = moves[g];
+        mUncovered[g] = 0;
+        if(m.action == Action::none || mState[g] != GameState::running)
+            continue;
+        const int n = index(m.i, m.j);
+        switch(m.action)
+        {
+        case Action::uncover:
+            p_open(g, n);
+            break;
+        case Action::chord:
+            p_chord(g, n);
+            break;
+        case Action::click:
+            if(p_get(mVisible, g, n))
+                p_chord(g, n);
+            else if(!p_get(mFlags, g, n))
+                p_open(g, n);
+            break;
+        case Action::toggle_flag:
+            mFlags[n*mGroups + g / word_bits] ^= Word(1) << (g % word_bits);
+            break;
+        case Action::none:
+            break;
+        }
+    }
+
+    p_spread();
+
+    results.resize(mGames);
+    for(std::size_t g = 0; g < mGames; ++g)
+    {
+        if(mState[g] == GameState::running && mCovered[g] == 0)
+            mState[g] = GameState::win;
+        results[g].uncovered = mUncovered[g];
+        results[g].state = mState[g];
+    }
+}
+
+void BatchedMinesweeper::p_open(std::size_t g, int n)
+{
+    const std::size_t x = n*mGroups + g / word_bits;
+    const Word bit = Word(1) << (g % word_bits);
+    if(mMines[x] & bit)
+    {
+        mState[g] = GameState::loss;
+        return;
+    }
+    if(!mPending[x])
+        mStack.push_back(x);
+    mPending[x] |= bit;
+}
+
+void BatchedMinesweeper::p_chord(std::size_t g, int n)
+{
+    if(!p_get(mVisible, g, n))
+        return;
+    int markeds = 0;
+    for(int off: mNbOffsets)
+        markeds += p_get(mFlags, g, n + off);
+    if(markeds != p_adjacents(g, n / mStride - 1, n % mStride - 1))
+        return;
+    for(int off: mNbOffsets)
+    {
+        if(!p_get(mFlags, g, n + off))
+            p_open(g, n + off);
+    }
+}
+
+void BatchedMinesweeper::p_spread()
+{
+    const std::size_t w_stride = mGroups;
+    while(!mStack.empty())
+    {
+        const std::size_t x = mStack.back();
+        mStack.pop_back();
+        const Word fresh = mPending[x] & ~mVisible[x];
+        mPending[x] = 0;
+        if(!fresh)
+            continue;
+        mVisible[x] |= fresh;
+
+        const std::size_t base = (x % w_stride) * word_bits;
+        for(Word bits = fresh; bits; bits &= bits - 1)
+        {
+            const std::size_t g = base + lowest_bit(bits);
+            ++mUncovered[g];
+            --mCovered[g];
+        }
+
+        //The games in which the cell is a zero open its neighbors
+        const Word zero = fresh & mZero[x];
+        if(!zero)
+            continue;
+        for(int off: mNbOffsets)
+        {
+            const std::size_t y = x + off*std::ptrdiff_t(w_stride);
+            const Word add = zero & ~mVisible[y];
+            if(!add)
+                continue;
+            if(!mPending[y])
+                mStack.push_back(y);
+            mPending[y] |= add;
+        }
+    }
+}
+
+void BatchedMinesweeper::replay(std::size_t g)
+{
+    const std::size_t w = g / word_bits;
+    const Word keep = ~(Word(1) << (g % word_bits));
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        const std::size_t x = index(i, j)*mGroups + w;
+        mVisible[x] &= keep;
+        mFlags[x] &= keep;
+    }
+    mCovered[g] = cells() - mMineCount[g];
+    mState[g] = GameState::running;
+}
+
+void BatchedMinesweeper::reset(std::size_t g)
+{
+    const std::size_t w = g / word_bits;
+    const Word keep = ~(Word(1) << (g % word_bits));
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        const std::size_t x = index(i, j)*mGroups + w;
+        mMines[x] &= keep;
+        mVisible[x] &= keep;
+        mFlags[x] &= keep;
+    }
+    mCovered[g] = 0;
+    mMineCount[g] = 0;
+    mState[g] = GameState::uninitialized;
+}
@@ -0,0 +1,217 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef BATCHED_MINESWEEPER_H_INCLUDED
+#define BATCHED_MINESWEEPER_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** \brief Many games of the same size, stepped together
+ *
+ * The games are stored bit-sliced: for each cell there is one 64 bit word per group of
+ * 64 games, bit \c g % 64 of word \c g / 64 belonging to game \c g, and there is such a
+ * plane for the mines, the uncovered cells, the flags and each bit of the numbers.
+ * The numbers are computed for 64 games at once with a bit-sliced adder, and the openings
+ * of all games of a step spread together, one word per cell and group, so the work is
+ * shared by the games which uncover the same cell. Like Minesweeper, the field has a
+ * border ring, so neighbors are visited without range checks.
+ *
+ * step() takes one move per game and returns one result per game. The rules are the ones
+ * of Minesweeper; a game which hits a mine is lost even if the same move would win it.
+ * \note Methods beginning with \c p_ are "cheating functions".
+ */
+class BatchedMinesweeper
+{
+public:
+    typedef Minesweeper::GameState GameState;
+    typedef std::uint64_t Word;
+
+    ///What a Move does
+    enum class Action : char
+    {
+        ///Leaves the game alone
+        none,
+        ///Minesweeper::uncover()
+        uncover,
+        ///Minesweeper::chord()
+        chord,
+        ///Minesweeper::click()
+        click,
+        ///Minesweeper::toggle_flag()
+        toggle_flag
+    };
+
+    ///A move of one game
+    struct Move
+    {
+        int i, j;
+        Action action;
+    };
+
+    ///The outcome of a move of one game
+    struct Result
+    {
+        ///The number of cells uncovered by the move
+        unsigned int uncovered;
+        ///The state of the game after the move
+        GameState state;
+    };
+
+    /** \brief Creates \c games uninitialized games of \c rows times \c cols cells
+     * \throw std::out_of_range if rows or cols is not positive
+     */
+    BatchedMinesweeper(std::size_t games, int rows, int cols);
+
+    ///Returns the number of games
+    std::size_t games() const { return mGames; }
+    ///Returns the number of rows
+    int rows() const { return mRows; }
+    ///Returns the number of columns
+    int cols() const { return mCols; }
+    ///Returns the number of cells of a game
+    unsigned int cells() const { return mRows*mCols; }
+
+    ///Returns the state of game \c g
+    GameState state(std::size_t g) const { return mState[g]; }
+    ///Returns the number of covered cells without a mine of game \c g
+    unsigned int covered(std::size_t g) const { return mCovered[g]; }
+
+    ///Returns if the cell (\c i, \c j) of game \c g is uncovered. No range check is done.
+    bool visible(std::size_t g, int i, int j) const { return p_get(mVisible, g, index(i, j)); }
+    ///Returns if the cell (\c i, \c j) of game \c g is flagged. No range check is done.
+    bool flagged(std::size_t g, int i, int j) const { return p_get(mFlags, g, index(i, j)); }
+    ///Returns the number on the cell (\c i, \c j) of game \c g if it is uncovered, or -1 otherwise
+    int adjacents(std::size_t g, int i, int j) const { return visible(g, i, j) ? p_adjacents(g, i, j) : -1; }
+
+    /** \brief Initializes game \c g with randomly placed mines
+     * \sa Minesweeper::rand_init()
+     */
+    template<class RNG> void rand_init(std::size_t g, unsigned int mines, RNG& rng,
+                                       int startr = -1, int startc = -1, bool safe_nbs = false);
+
+    /** \brief Initializes game \c g after its mines have been placed
+     *
+     * This computes the numbers of the 64 games of the group of \c g at once,
+     * so when initializing many games, the mines of all of them should be placed first.
+     */
+    void init(std::size_t g);
+
+    ///Initializes all games after their mines have been placed
+    void init();
+
+    /** \brief Makes one move in each game
+     * \param moves The move of game \c g at index \c g, for all games
+     * \param results Receives the result of game \c g at index \c g
+     * \throw std::invalid_argument if the number of moves is not the number of games
+     *
+     * Moves on games which are not running do nothing.
+     */
+    void step(const std::vector<Move>& moves, std::vector<Result>& results);
+
+    ///Covers and unmarks all cells of game \c g. The mines are left as they were.
+    void replay(std::size_t g);
+
+    ///Resets game \c g into the uninitialized state
+    void reset(std::size_t g);
+
+    ///Returns if the cell (\c i, \c j) of game \c g contains a mine
+    bool p_mine(std::size_t g, int i, int j) const { return p_get(mMines, g, index(i, j)); }
+    ///Returns the number of mines around the cell (\c i, \c j) of game \c g
+    int p_adjacents(std::size_t g, int i, int j) const;
+    ///Sets whether the cell (\c i, \c j) of game \c g contains a mine. Has to be called before init().
+    void p_set_mine(std::size_t g, int i, int j, bool mine);
+
+private:
+    ///Number of bits in a Word
+    static const int word_bits = 64;
+
+    std::size_t mGames;
+    int mRows, mCols;
+    ///Distance between two rows in cells. Each row has a border cell on both sides.
+    int mStride;
+    ///Number of words per cell, i.e. groups of 64 games
+    std::size_t mGroups;
+    ///Offsets of the neighbors in cells, in the order of Minesweeper::for_each_nb_in_range()
+    int mNbOffsets[8];
+
+    ///The planes, with the word of group w of cell n at n*mGroups + w
+    std::vector<Word> mMines;
+    ///Uncovered cells. The border cells are uncovered in all games.
+    std::vector<Word> mVisible;
+    std::vector<Word> mFlags;
+    ///The games in which a cell has no adjacent mines and is no mine itself
+    std::vector<Word> mZero;
+    ///The numbers of adjacent mines in binary
+    std::vector<Word> mAdjacents[4];
+    ///Cells to be uncovered by the running step, as games per word
+    std::vector<Word> mPending;
+    ///Words of mPending which are not zero
+    std::vector<std::size_t> mStack;
+
+    std::vector<GameState> mState;
+    std::vector<unsigned int> mCovered;
+    std::vector<unsigned int> mMineCount;
+    ///Cells uncovered in each game by the running step
+    std::vector<unsigned int> mUncovered;
+
+    ///Returns the index of the cell (\c i, \c j) including the border
+    int index(int i, int j) const { return (i+1)*mStride + j+1; }
+
+    bool p_get(const std::vector<Word>& plane, std::size_t g, int n) const
+    {
+        return plane[n*mGroups + g / word_bits] >> (g % word_bits) & 1;
+    }
+
+    ///Computes the numbers and zero cells of group \c w
+    void p_count(std::size_t w);
+
+    ///Marks the cell \c n of game \c g to be uncovered, or loses the game if it is a mine
+    void p_open(std::size_t g, int n);
+
+    ///Marks the unflagged neighbors of the cell \c n of game \c g to be uncovered, like Minesweeper::chord()
+    void p_chord(std::size_t g, int n);
+
+    ///Uncovers the pending cells and spreads the openings of all games
+    void p_spread();
+};
+
+template<class RNG> void BatchedMinesweeper::rand_init(std::size_t g, unsigned int mines, RNG& rng,
+                                                       int startr, int startc, bool safe_nbs)
+{
+    if(mState[g] != GameState::uninitialized)
+        throw std::runtime_error("The field has already been initialized");
+
+    Minesweeper::sample_cells(mRows, mCols, mines, rng, startr, startc, safe_nbs, [this, g](int i, int j)
+    {
+        if(p_mine(g, i, j))
+            return false;
+        p_set_mine(g, i, j, true);
+        return true;
+    });
+
+    init(g);
+}
+
+#endif
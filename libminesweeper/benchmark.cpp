@@ -0,0 +1,415 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Microbenchmarks of the hot paths of Minesweeper.
+ *
+ * Every operation is timed over a matrix of field sizes and mine densities. Each measurement
+ * consists of several samples which run for a minimum time each, and the median, minimum and
+ * median absolute deviation of the time per operation are reported, together with the number
+ * of cells processed per second. The results can be written to a JSON file and compared
+ * against such a file written before.
+ */
+
+#include "minesweeper.h"
+#include "seeded_layout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options
+{
+    unsigned int samples = 7;
+    double min_time = 0.02;
+    std::uint64_t max_cells = 4096ull*4096;
+    std::string filter;
+    std::string json;
+    std::string baseline;
+};
+
+struct Result
+{
+    std::string name;
+    int rows, cols;
+    double density;
+    ///Cells processed by one operation
+    std::uint64_t cells;
+    double median_ns, min_ns, mad_ns;
+    std::uint64_t iterations;
+};
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v.size() % 2 ? v[v.size()/2] : (v[v.size()/2 - 1] + v[v.size()/2]) / 2;
+}
+
+void summarize(Result& res, const std::vector<double>& ns)
+{
+    res.median_ns = median(ns);
+    res.min_ns = *std::min_element(ns.begin(), ns.end());
+    std::vector<double> dev;
+    for(double x: ns)
+        dev.push_back(std::fabs(x - res.median_ns));
+    res.mad_ns = median(dev);
+}
+
+///Times \c op in batches of iterations, for operations which need no preparation
+template<class Op> void measure(const Options& opt, Result& res, Op op)
+{
+    //Find the number of iterations which takes at least the minimum time
+    std::uint64_t iters = 1;
+    while(true)
+    {
+        const auto begin = Clock::now();
+        for(std::uint64_t it = 0; it < iters; ++it)
+            op();
+        const double t = std::chrono::duration<double>(Clock::now() - begin).count();
+        if(t >= opt.min_time)
+            break;
+        iters = t > 0.0 ? std::max<std::uint64_t>(iters * 2, iters * 1.2 * opt.min_time / t) : iters * 2;
+    }
+
+    std::vector<double> ns;
+    for(unsigned int s = 0; s < opt.samples; ++s)
+    {
+        const auto begin = Clock::now();
+        for(std::uint64_t it = 0; it < iters; ++it)
+            op();
+        ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / iters);
+    }
+    res.iterations = iters * opt.samples;
+    summarize(res, ns);
+}
+
+///Times \c op individually, running the untimed \c setup before each call
+template<class Setup, class Op> void measure(const Options& opt, Result& res, Setup setup, Op op)
+{
+    std::vector<double> ns;
+    res.iterations = 0;
+    setup();
+    op();
+    for(unsigned int s = 0; s < opt.samples; ++s)
+    {
+        double t = 0.0;
+        std::uint64_t iters = 0;
+        //Quick operations with an expensive setup stop at a multiple of the minimum time
+        const auto deadline = Clock::now() + std::chrono::duration<double>(opt.min_time * 10);
+        while(t < opt.min_time && (iters == 0 || Clock::now() < deadline))
+        {
+            setup();
+            const auto begin = Clock::now();
+            op();
+            t += std::chrono::duration<double>(Clock::now() - begin).count();
+            ++iters;
+        }
+        ns.push_back(t * 1e9 / iters);
+        res.iterations += iters;
+    }
+    summarize(res, ns);
+}
+
+std::uint64_t visible_cells(const Minesweeper& ms)
+{
+    std::uint64_t n = 0;
+    for(int i = 0; i < ms.rows(); ++i)
+    for(int j = 0; j < ms.cols(); ++j)
+        n += ms.cell(i, j).visible();
+    return n;
+}
+
+class Runner
+{
+public:
+    explicit Runner(const Options& opt): opt(opt) {}
+
+    ///Runs all benchmarks of a field size and density
+    void run(int rows, int cols, double density);
+
+    const std::vector<Result>& results() const { return res; }
+
+private:
+    const Options& opt;
+    std::vector<Result> res;
+
+    ///Runs \c bench if its name passes the filter
+    template<class Bench> void add(const std::string& op, int rows, int cols, double density, std::uint64_t cells, Bench bench);
+};
+
+template<class Bench> void Runner::add(const std::string& op, int rows, int cols, double density, std::uint64_t cells, Bench bench)
+{
+    std::ostringstream name;
+    name << op << '/' << rows << 'x' << cols << '/' << density;
+    if(name.str().find(opt.filter) == std::string::npos)
+        return;
+
+    Result r;
+    r.name = name.str();
+    r.rows = rows;
+    r.cols = cols;
+    r.density = density;
+    r.cells = cells;
+    bench(r);
+    res.push_back(r);
+
+    std::cout << std::left << std::setw(32) << r.name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(16) << r.median_ns << " ns/op +- " << std::setw(10) << r.mad_ns
+              << std::scientific << std::setprecision(3) << std::setw(14) << r.cells * 1e9 / r.median_ns << " cells/s"
+              << std::endl;
+}
+
+void Runner::run(int rows, int cols, double density)
+{
+    const unsigned int mines = std::max(1.0, std::round(rows * cols * density));
+    const int startr = rows / 2, startc = cols / 2;
+    const std::uint64_t cells = std::uint64_t(rows) * cols;
+    std::mt19937 rng(42);
+
+    Minesweeper ms(rows, cols);
+    add("rand_init", rows, cols, density, cells, [&](Result& r)
+    {
+        measure(opt, r, [&]() { ms.reset(); }, [&]() { ms.rand_init(mines, rng, startr, startc, true); });
+    });
+    const SeededLayout layout(rows, cols, mines, 42, startr, startc, true);
+    add("seeded_init", rows, cols, density, cells, [&](Result& r)
+    {
+        measure(opt, r, [&]() { ms.reset(); }, [&]() { layout.apply(ms); });
+    });
+    if(ms.state() == Minesweeper::GameState::uninitialized)
+        ms.rand_init(mines, rng, startr, startc, true);
+
+    std::vector<Minesweeper::Position> mine_cells;
+    for(int i = 0; i < rows; ++i)
+    for(int j = 0; j < cols; ++j)
+    {
+        if(ms.cell(i, j).p_mine())
+            mine_cells.emplace_back(i, j);
+    }
+
+    add("init", rows, cols, density, cells, [&](Result& r)
+    {
+        measure(opt, r, [&]() { ms.init(); });
+    });
+
+    //The starting area is free of mines, so this uncovers the opening around it
+    ms.replay();
+    ms.uncover(startr, startc);
+    add("uncover", rows, cols, density, visible_cells(ms), [&](Result& r)
+    {
+        measure(opt, r, [&]() { ms.replay(); }, [&]() { ms.uncover(startr, startc); });
+    });
+
+    //With all mines flagged, chording spreads from the opening over the whole field
+    auto prepare_chord = [&]()
+    {
+        ms.replay();
+        for(const Minesweeper::Position& p: mine_cells)
+            ms.set_flag(p.first, p.second, true);
+        ms.uncover(startr, startc);
+    };
+    prepare_chord();
+    const std::uint64_t opened = visible_cells(ms);
+    ms.chord_all();
+    add("chord_all", rows, cols, density, visible_cells(ms) - opened, [&](Result& r)
+    {
+        measure(opt, r, prepare_chord, [&]() { ms.chord_all(); });
+    });
+
+    //replay() and reset() only visit the cells touched since the last one, here the opening
+    auto prepare_opening = [&]()
+    {
+        ms.replay();
+        ms.uncover(startr, startc);
+    };
+    prepare_opening();
+    const std::uint64_t touched = visible_cells(ms);
+    add("replay", rows, cols, density, touched, [&](Result& r)
+    {
+        measure(opt, r, prepare_opening, [&]() { ms.replay(); });
+    });
+
+    prepare_opening();
+    add("operator<<", rows, cols, density, cells, [&](Result& r)
+    {
+        std::ostringstream os;
+        measure(opt, r, [&]()
+        {
+            os.str(std::string());
+            os << ms;
+        });
+    });
+
+    //reset() visits the mines as well. The game is set up again from the layout each time.
+    auto prepare_reset = [&]()
+    {
+        ms.reset();
+        layout.apply(ms);
+        ms.uncover(startr, startc);
+    };
+    prepare_reset();
+    add("reset", rows, cols, density, visible_cells(ms) + mines, [&](Result& r)
+    {
+        measure(opt, r, prepare_reset, [&]() { ms.reset(); });
+    });
+}
+
+void write_json(const std::string& file, const std::vector<Result>& results)
+{
+    std::ofstream os(file);
+    if(!os)
+        throw std::runtime_error("Could not open " + file);
+    os << std::setprecision(10) << "{\"benchmarks\": [\n";
+    for(std::size_t n = 0; n < results.size(); ++n)
+    {
+        const Result& r = results[n];
+        os << "  {\"name\": \"" << r.name << "\", \"rows\": " << r.rows << ", \"cols\": " << r.cols
+           << ", \"density\": " << r.density << ", \"ns_per_op\": " << r.median_ns
+           << ", \"min_ns\": " << r.min_ns << ", \"mad_ns\": " << r.mad_ns
+           << ", \"cells_per_second\": " << r.cells * 1e9 / r.median_ns
+           << ", \"iterations\": " << r.iterations << '}' << (n + 1 < results.size() ? "," : "") << '\n';
+    }
+    os << "]}\n";
+}
+
+///Reads the times per operation from a file written by write_json()
+std::map<std::string, double> read_json(const std::string& file)
+{
+    std::ifstream is(file);
+    if(!is)
+        throw std::runtime_error("Could not open " + file);
+    std::map<std::string, double> times;
+    std::string line;
+    const std::string name_key = "\"name\": \"", ns_key = "\"ns_per_op\": ";
+    while(std::getline(is, line))
+    {
+        const std::size_t name = line.find(name_key), ns = line.find(ns_key);
+        if(name == std::string::npos || ns == std::string::npos)
+            continue;
+        const std::size_t begin = name + name_key.size();
+        times[line.substr(begin, line.find('"', begin) - begin)] = std::atof(line.c_str() + ns + ns_key.size());
+    }
+    return times;
+}
+
+void compare(const std::vector<Result>& results, const std::map<std::string, double>& baseline)
+{
+    std::cout << "\nChange against the baseline (negative is faster):\n";
+    for(const Result& r: results)
+    {
+        auto it = baseline.find(r.name);
+        if(it == baseline.end())
+            continue;
+        std::cout << std::left << std::setw(32) << r.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << (r.median_ns / it->second - 1.0) * 100 << " %\n";
+    }
+}
+
+void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [options]\n"
+        "  --samples N      Samples per benchmark (default 7)\n"
+        "  --min-time MS    Minimal duration of a sample in milliseconds (default 20)\n"
+        "  --max-cells N    Skip fields with more cells (default 4096*4096)\n"
+        "  --filter TEXT    Only run benchmarks whose name contains TEXT\n"
+        "  --json FILE      Write the results to FILE\n"
+        "  --baseline FILE  Compare the results against FILE, written by --json before\n";
+}
+
+bool parse(int argc, char** argv, Options& opt)
+{
+    for(int a = 1; a + 1 < argc; a += 2)
+    {
+        const std::string arg = argv[a], val = argv[a+1];
+        if(arg == "--samples")
+            opt.samples = std::max(1, std::atoi(val.c_str()));
+        else if(arg == "--min-time")
+            opt.min_time = std::atof(val.c_str()) / 1000;
+        else if(arg == "--max-cells")
+            opt.max_cells = std::strtoull(val.c_str(), nullptr, 10);
+        else if(arg == "--filter")
+            opt.filter = val;
+        else if(arg == "--json")
+            opt.json = val;
+        else if(arg == "--baseline")
+            opt.baseline = val;
+        else
+            return false;
+    }
+    return argc % 2 == 1;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if(!parse(argc, argv, opt))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+#if !defined(__OPTIMIZE__) && !defined(NDEBUG)
+    std::cerr << "Warning: the benchmark has been built without optimization, "
+                 "configure with -DCMAKE_BUILD_TYPE=Release for meaningful results\n";
+#endif
+
+    const int sizes[][2] = {{9, 9}, {16, 16}, {16, 30}, {100, 100}, {512, 512}, {1024, 1024}, {4096, 4096}};
+    const double densities[] = {0.01, 0.12, 0.21};
+
+    try
+    {
+        Runner runner(opt);
+        for(const auto& size: sizes)
+        {
+            if(std::uint64_t(size[0]) * size[1] > opt.max_cells)
+                continue;
+            for(double density: densities)
+                runner.run(size[0], size[1], density);
+        }
+
+        if(!opt.json.empty())
+            write_json(opt.json, runner.results());
+        if(!opt.baseline.empty())
+            compare(runner.results(), read_json(opt.baseline));
+    }
+    catch(std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
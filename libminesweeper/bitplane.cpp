@@ -0,0 +1,184 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bitplane.h"
+
+#include <algorithm>
+#include <bitset>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+///Word operations for the portable adjacency kernel
+struct ScalarOps
+{
+    typedef BitPlane::Word Vec;
+    static const int width = 1;
+
+    static Vec load(const BitPlane::Word* p) { return *p; }
+    static void store(BitPlane::Word* p, Vec v) { *p = v; }
+    static Vec bit_and(Vec a, Vec b) { return a & b; }
+    static Vec bit_or(Vec a, Vec b) { return a | b; }
+    static Vec bit_xor(Vec a, Vec b) { return a ^ b; }
+    static Vec shl1(Vec a) { return a << 1; }
+    static Vec shr1(Vec a) { return a >> 1; }
+    static Vec shl63(Vec a) { return a << 63; }
+    static Vec shr63(Vec a) { return a >> 63; }
+};
+
+#if defined(__AVX2__)
+///Word operations for the AVX2 adjacency kernel
+struct SimdOps
+{
+    typedef __m256i Vec;
+    static const int width = 4;
+
+    static Vec load(const BitPlane::Word* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(BitPlane::Word* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static Vec bit_and(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+    static Vec bit_or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+    static Vec bit_xor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+    static Vec shl1(Vec a) { return _mm256_slli_epi64(a, 1); }
+    static Vec shr1(Vec a) { return _mm256_srli_epi64(a, 1); }
+    static Vec shl63(Vec a) { return _mm256_slli_epi64(a, 63); }
+    static Vec shr63(Vec a) { return _mm256_srli_epi64(a, 63); }
+};
+#elif defined(__SSE2__)
+///Word operations for the SSE2 adjacency kernel
+struct SimdOps
+{
+    typedef __m128i Vec;
+    static const int width = 2;
+
+    static Vec load(const BitPlane::Word* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(BitPlane::Word* p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static Vec bit_and(Vec a, Vec b) { return _mm_and_si128(a, b); }
+    static Vec bit_or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+    static Vec bit_xor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+    static Vec shl1(Vec a) { return _mm_slli_epi64(a, 1); }
+    static Vec shr1(Vec a) { return _mm_srli_epi64(a, 1); }
+    static Vec shl63(Vec a) { return _mm_slli_epi64(a, 63); }
+    static Vec shr63(Vec a) { return _mm_srli_epi64(a, 63); }
+};
+#else
+typedef ScalarOps SimdOps;
+#endif
+
+/** \brief Counts the adjacent bits for the words [\c w, \c w + Ops::width) of a row
+ *
+ * \c up, \c mid and \c down point to the first words of the rows above, at and below.
+ * The words left and right of the range are read to carry bits across word boundaries.
+ */
+template<class Ops> inline void count_words(const BitPlane::Word* up, const BitPlane::Word* mid, const BitPlane::Word* down,
+                                            BitPlane::Word* const (&out)[4], int w)
+{
+    typedef typename Ops::Vec Vec;
+    //Column j-1 shifted to position j, and column j+1 shifted to position j
+    auto west = [w](const BitPlane::Word* r) { return Ops::bit_or(Ops::shl1(Ops::load(r + w)), Ops::shr63(Ops::load(r + w - 1))); };
+    auto east = [w](const BitPlane::Word* r) { return Ops::bit_or(Ops::shr1(Ops::load(r + w)), Ops::shl63(Ops::load(r + w + 1))); };
+    auto maj = [](Vec a, Vec b, Vec c) { return Ops::bit_or(Ops::bit_and(a, b), Ops::bit_and(c, Ops::bit_or(a, b))); };
+    auto xor3 = [](Vec a, Vec b, Vec c) { return Ops::bit_xor(Ops::bit_xor(a, b), c); };
+
+    Vec a = west(up),   b = Ops::load(up + w),   c = east(up);
+    Vec d = west(mid),                           e = east(mid);
+    Vec f = west(down), g = Ops::load(down + w), h = east(down);
+
+    //Carry-save addition of the eight one bit inputs
+    Vec s0 = xor3(a, b, c), c0 = maj(a, b, c);
+    Vec s1 = xor3(d, e, f), c1 = maj(d, e, f);
+    Vec s2 = Ops::bit_xor(g, h), c2 = Ops::bit_and(g, h);
+    Vec carry = maj(s0, s1, s2);
+    Vec twos = xor3(c0, c1, c2), fours = maj(c0, c1, c2);
+    Vec fours2 = Ops::bit_and(twos, carry);
+
+    Ops::store(out[0] + w, xor3(s0, s1, s2));
+    Ops::store(out[1] + w, Ops::bit_xor(twos, carry));
+    Ops::store(out[2] + w, Ops::bit_xor(fours, fours2));
+    Ops::store(out[3] + w, Ops::bit_and(fours, fours2));
+}
+
+}
+
+BitPlane::BitPlane():
+    mRows(0),
+    mCols(0),
+    mWords(0),
+    mStride(2),
+    mData(2*mStride, 0)
+{}
+
+BitPlane::BitPlane(int rows, int cols):
+    mRows(rows),
+    mCols(cols),
+    mWords((cols + word_bits - 1) / word_bits),
+    mStride(mWords + 2),
+    mData(std::size_t(rows + 2)*mStride, 0)
+{
+    if(rows < 0 || cols < 0)
+        throw std::out_of_range("The number of rows and columns must not be negative");
+}
+
+void BitPlane::set(int i, int j, bool value)
+{
+    Word& w = row(i)[j / word_bits];
+    const Word mask = Word(1) << (j % word_bits);
+    if(value)
+        w |= mask;
+    else
+        w &= ~mask;
+}
+
+void BitPlane::clear()
+{
+    std::fill(mData.begin(), mData.end(), 0);
+}
+
+std::uint64_t BitPlane::count() const
+{
+    std::uint64_t n = 0;
+    for(Word w: mData)
+        n += std::bitset<word_bits>(w).count();
+    return n;
+}
+
+void BitPlane::count_adjacents(const BitPlane& plane, BitPlane (&counts)[4])
+{
+    for(BitPlane& c: counts)
+    {
+        if(c.mRows != plane.mRows || c.mCols != plane.mCols)
+            c = BitPlane(plane.mRows, plane.mCols);
+    }
+
+    const int simd_end = plane.mWords - plane.mWords % SimdOps::width;
+    for(int i = 0; i < plane.mRows; ++i)
+    {
+        Word* const out[4] = { counts[0].row(i), counts[1].row(i), counts[2].row(i), counts[3].row(i) };
+        int w = 0;
+        for(; w < simd_end; w += SimdOps::width)
+            count_words<SimdOps>(plane.row(i-1), plane.row(i), plane.row(i+1), out, w);
+        for(; w < plane.mWords; ++w)
+            count_words<ScalarOps>(plane.row(i-1), plane.row(i), plane.row(i+1), out, w);
+    }
+}
@@ -0,0 +1,94 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BITPLANE_H_INCLUDED
+#define BITPLANE_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** \brief A field of bits, one per cell, stored row by row in 64 bit words
+ *
+ * Bit \c j % 64 of word \c j / 64 of a row belongs to column \c j.
+ * Each row is surrounded by a zero word on both sides and the field by a zero row
+ * above and below, so that the neighbors of every cell can be read without range checks.
+ * The bits past the last column are always zero as long as only set() and clear() are used.
+ * Rows and columns are limited to int, but the field may have more than 2^32 cells.
+ */
+class BitPlane
+{
+public:
+    typedef std::uint64_t Word;
+
+    ///Number of bits in a Word
+    static const int word_bits = 64;
+
+    ///Creates an empty plane
+    BitPlane();
+
+    ///Creates a plane of \c rows times \c cols zero bits
+    BitPlane(int rows, int cols);
+
+    ///Returns the number of rows
+    int rows() const { return mRows; }
+    ///Returns the number of columns
+    int cols() const { return mCols; }
+    ///Returns the number of words of a row, without the padding
+    int words() const { return mWords; }
+
+    ///Returns the bit of cell (\c i, \c j). No range check is done.
+    bool get(int i, int j) const { return (row(i)[j / word_bits] >> (j % word_bits)) & 1; }
+    ///Sets the bit of cell (\c i, \c j). No range check is done.
+    void set(int i, int j, bool value = true);
+
+    ///Sets all bits to zero
+    void clear();
+
+    ///Returns the number of set bits
+    std::uint64_t count() const;
+
+    /** \brief Returns a pointer to the first word of row \c i
+     *
+     * Rows -1 and rows() and the words -1 and words() of each row may be read and are zero.
+     */
+    Word* row(int i) { return &mData[std::size_t(i+1)*mStride + 1]; }
+    ///\copydoc row()
+    const Word* row(int i) const { return &mData[std::size_t(i+1)*mStride + 1]; }
+
+    /** \brief Computes the number of adjacent bits of all cells
+     * \param plane The plane to count in, usually the mines
+     * \param counts Receives the counts in binary, counts[k] holding bit k
+     *
+     * The counts are computed with word parallel shifts and a bit-sliced adder,
+     * using SSE2 or AVX2 if they are enabled at compile time.
+     * The bits of \c counts past the last column are unspecified.
+     */
+    static void count_adjacents(const BitPlane& plane, BitPlane (&counts)[4]);
+
+private:
+    int mRows, mCols;
+    int mWords;
+    ///Number of words from one row to the next, including the padding
+    int mStride;
+    std::vector<Word> mData;
+};
+
+#endif
@@ -0,0 +1,240 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "chunked_minesweeper.h"
+#include "seeded_layout.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+
+const ChunkedMinesweeper::Coord coord_limit = ChunkedMinesweeper::Coord(1) << 37;
+
+///Chunk index and position within the chunk of a coordinate, also for negative ones
+inline std::int64_t chunk_of(std::int64_t x) { return x >> ChunkedMinesweeper::chunk_bits; }
+inline int local_of(std::int64_t x) { return int(x & (ChunkedMinesweeper::chunk_size - 1)); }
+
+}
+
+constexpr double ChunkedMinesweeper::min_density;
+
+ChunkedMinesweeper::ChunkedMinesweeper(double density, std::uint64_t seed, Coord startr, Coord startc):
+    mSeed(seed),
+    mStartr(startr), mStartc(startc),
+    mState(GameState::running),
+    mUncovered(0)
+{
+    if(!(density >= min_density && density < 1.0))
+        throw std::out_of_range("The density must be at least min_density and less than 1");
+    if(std::abs(startr) >= coord_limit - 1 || std::abs(startc) >= coord_limit - 1)
+        throw std::out_of_range("The starting position is too far out");
+    mThreshold = std::uint64_t(std::ldexp(density, 64));
+}
+
+bool ChunkedMinesweeper::visible(Coord i, Coord j) const
+{
+    const Chunk* c = p_find(i, j);
+    return c && (c->visible[local_of(i)] >> local_of(j) & 1);
+}
+
+bool ChunkedMinesweeper::flag(Coord i, Coord j) const
+{
+    const Chunk* c = p_find(i, j);
+    return c && (c->flags[local_of(i)] >> local_of(j) & 1);
+}
+
+int ChunkedMinesweeper::adjacents(Coord i, Coord j)
+{
+    return visible(i, j) ? p_adjacents(i, j) : -1;
+}
+
+int ChunkedMinesweeper::p_adjacents(Coord i, Coord j)
+{
+    const Chunk& c = p_numbered_chunk(i, j);
+    return c.mines[local_of(i)] >> local_of(j) & 1 ? -1 : c.adjacents[local_of(i)*chunk_size + local_of(j)];
+}
+
+bool ChunkedMinesweeper::p_mine(Coord i, Coord j)
+{
+    return p_chunk(i, j).mines[local_of(i)] >> local_of(j) & 1;
+}
+
+bool ChunkedMinesweeper::uncover(Coord i, Coord j)
+{
+    if(!running())
+        return false;
+    return p_open(i, j);
+}
+
+bool ChunkedMinesweeper::uncover_if_unmarked(Coord i, Coord j)
+{
+    if(flag(i, j))
+        return false;
+    return uncover(i, j);
+}
+
+bool ChunkedMinesweeper::chord(Coord i, Coord j)
+{
+    if(!running() || !visible(i, j))
+        return false;
+    int markeds = 0;
+    for_each_nb(i, j, [&](Coord k, Coord l) { markeds += flag(k, l); });
+    if(markeds != p_adjacents(i, j))
+        return false;
+    bool ret = false;
+    for_each_nb(i, j, [&](Coord k, Coord l)
+    {
+        if(running() && !flag(k, l))
+            ret = p_open(k, l) || ret;
+    });
+    return ret;
+}
+
+bool ChunkedMinesweeper::click(Coord i, Coord j)
+{
+    if(visible(i, j))
+        return chord(i, j);
+    else
+        return uncover_if_unmarked(i, j);
+}
+
+void ChunkedMinesweeper::set_flag(Coord i, Coord j, bool flag)
+{
+    std::uint64_t& row = p_chunk(i, j).flags[local_of(i)];
+    const std::uint64_t bit = std::uint64_t(1) << local_of(j);
+    row = flag ? row | bit : row & ~bit;
+}
+
+void ChunkedMinesweeper::toggle_flag(Coord i, Coord j)
+{
+    set_flag(i, j, !flag(i, j));
+}
+
+std::uint64_t ChunkedMinesweeper::p_key(Coord i, Coord j)
+{
+    if(i <= -coord_limit || i >= coord_limit || j <= -coord_limit || j >= coord_limit)
+        throw std::out_of_range("The cell is too far out");
+    return std::uint64_t(std::uint32_t(chunk_of(i))) << 32 | std::uint32_t(chunk_of(j));
+}
+
+auto ChunkedMinesweeper::p_find(Coord i, Coord j) const -> const Chunk*
+{
+    auto it = mChunks.find(p_key(i, j));
+    return it != mChunks.end() ? it->second.get() : nullptr;
+}
+
+auto ChunkedMinesweeper::p_chunk(Coord i, Coord j) -> Chunk&
+{
+    std::unique_ptr<Chunk>& c = mChunks[p_key(i, j)];
+    if(c)
+        return *c;
+
+    //Each chunk has its own stream, the value for a cell is picked by its position
+    c.reset(new Chunk());
+    const CounterRng rng(mSeed, p_key(i, j));
+    const Coord top = i - local_of(i), left = j - local_of(j);
+    for(int r = 0; r < chunk_size; ++r)
+    for(int s = 0; s < chunk_size; ++s)
+    {
+        const bool start = std::abs(top + r - mStartr) <= 1 && std::abs(left + s - mStartc) <= 1;
+        if(!start && rng.at(r*chunk_size + s) < mThreshold)
+            c->mines[r] |= std::uint64_t(1) << s;
+    }
+    return *c;
+}
+
+auto ChunkedMinesweeper::p_numbered_chunk(Coord i, Coord j) -> Chunk&
+{
+    Chunk& c = p_chunk(i, j);
+    if(c.adjacents.empty())
+        p_number(c, i, j);
+    return c;
+}
+
+void ChunkedMinesweeper::p_number(Chunk& c, Coord i, Coord j)
+{
+    //The mines of the chunk and the rows of the neighboring chunks next to it,
+    //with one more column on either side
+    const Coord top = i - local_of(i), left = j - local_of(j);
+    const int size = chunk_size + 2;
+    std::vector<std::uint8_t> mines(size * size, 0);
+    for(int dr = -1; dr <= 1; ++dr)
+    for(int ds = -1; ds <= 1; ++ds)
+    {
+        const Chunk& nb = dr == 0 && ds == 0 ? c : p_chunk(top + dr*chunk_size, left + ds*chunk_size);
+        const int r0 = dr < 0 ? chunk_size - 1 : 0, r1 = dr > 0 ? 1 : chunk_size;
+        const int s0 = ds < 0 ? chunk_size - 1 : 0, s1 = ds > 0 ? 1 : chunk_size;
+        for(int r = r0; r < r1; ++r)
+        for(int s = s0; s < s1; ++s)
+            mines[(dr*chunk_size + r + 1)*size + ds*chunk_size + s + 1] = nb.mines[r] >> s & 1;
+    }
+
+    c.adjacents.resize(chunk_size * chunk_size);
+    for(int r = 0; r < chunk_size; ++r)
+    for(int s = 0; s < chunk_size; ++s)
+    {
+        const std::uint8_t* above = &mines[r*size + s];
+        const std::uint8_t* here = above + size;
+        const std::uint8_t* below = here + size;
+        c.adjacents[r*chunk_size + s] = above[0] + above[1] + above[2] + here[0] + here[2] + below[0] + below[1] + below[2];
+    }
+}
+
+bool ChunkedMinesweeper::p_open(Coord i, Coord j)
+{
+    {
+        Chunk& c = p_numbered_chunk(i, j);
+        const std::uint64_t bit = std::uint64_t(1) << local_of(j);
+        if(c.visible[local_of(i)] & bit)
+            return false;
+        if(c.mines[local_of(i)] & bit)
+        {
+            mState = GameState::loss;
+            return false;
+        }
+    }
+
+    //Uncover the area of cells without adjacent mines
+    mOpenStack.clear();
+    mOpenStack.emplace_back(i, j);
+    while(!mOpenStack.empty())
+    {
+        const Position p = mOpenStack.back();
+        mOpenStack.pop_back();
+        Chunk& c = p_numbered_chunk(p.first, p.second);
+        const int r = local_of(p.first), s = local_of(p.second);
+        if(c.visible[r] >> s & 1)
+            continue;
+        c.visible[r] |= std::uint64_t(1) << s;
+        ++mUncovered;
+        if(c.adjacents[r*chunk_size + s] == 0)
+        {
+            for_each_nb(p.first, p.second, [this](Coord k, Coord l)
+            {
+                if(!visible(k, l))
+                    mOpenStack.emplace_back(k, l);
+            });
+        }
+    }
+    return true;
+}
@@ -0,0 +1,164 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CHUNKED_MINESWEEPER_H_INCLUDED
+#define CHUNKED_MINESWEEPER_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** \brief Minesweeper game on an unbounded field which is generated as it is explored
+ *
+ * The field is split into chunks of 64x64 cells. The mines of a chunk are a function of the
+ * seed and the chunk's position, so they are only generated when a move or query reaches
+ * the chunk, or a neighboring one which needs them for its numbers. The numbers of a chunk
+ * are computed when one of its cells is uncovered or asked for. So the memory used grows
+ * with the explored area, not with the size of the field.
+ *
+ * Every cell is a mine with the given density, except for the starting position and its
+ * neighbors, so the first move at the starting position always opens an area. As the field
+ * never ends, the game can only be lost; uncovered() serves as score.
+ * Coordinates may be negative and have to be within +-2^37.
+ * \note Methods beginning with \c p_ are "cheating functions".
+ */
+class ChunkedMinesweeper
+{
+public:
+    typedef Minesweeper::GameState GameState;
+    typedef std::int64_t Coord;
+    typedef std::pair<Coord, Coord> Position;
+
+    ///Rows and columns of a chunk are 2^chunk_bits
+    static const int chunk_bits = 6;
+    static const int chunk_size = 1 << chunk_bits;
+
+    /** \brief Smallest allowed density
+     *
+     * Below that, the areas of cells without adjacent mines become so large
+     * that a single move could uncover an unbounded area.
+     */
+    static constexpr double min_density = 0.15;
+
+    /** \brief Creates the game
+     * \param density The probability of a cell being a mine
+     * \param seed The seed of the field
+     * \throw std::out_of_range if density is not in [min_density, 1)
+     */
+    ChunkedMinesweeper(double density, std::uint64_t seed, Coord startr = 0, Coord startc = 0);
+
+    ///Returns the current state of the game
+    GameState state() const { return mState; }
+    ///Returns if the game is in progress
+    bool running() const { return mState == GameState::running; }
+
+    ///Returns the number of uncovered cells
+    std::uint64_t uncovered() const { return mUncovered; }
+    ///Returns the number of chunks in memory
+    std::size_t chunks() const { return mChunks.size(); }
+
+    ///Returns if the cell (\c i, \c j) is uncovered
+    bool visible(Coord i, Coord j) const;
+    ///Returns if the cell (\c i, \c j) is flagged
+    bool flag(Coord i, Coord j) const;
+    ///Returns the number of mines around (\c i, \c j) if the cell is uncovered, or -1 otherwise
+    int adjacents(Coord i, Coord j);
+    ///Returns the number of mines around (\c i, \c j), or -1 if the cell contains a mine
+    int p_adjacents(Coord i, Coord j);
+    ///Returns if the cell (\c i, \c j) contains a mine
+    bool p_mine(Coord i, Coord j);
+
+    ///\copydoc Minesweeper::uncover()
+    bool uncover(Coord i, Coord j);
+    ///\copydoc Minesweeper::uncover_if_unmarked()
+    bool uncover_if_unmarked(Coord i, Coord j);
+    ///\copydoc Minesweeper::chord()
+    bool chord(Coord i, Coord j);
+    ///\copydoc Minesweeper::click()
+    bool click(Coord i, Coord j);
+
+    ///Flags or unflags the cell (\c i, \c j)
+    void set_flag(Coord i, Coord j, bool flag);
+    ///Toggles the flag of the cell (\c i, \c j)
+    void toggle_flag(Coord i, Coord j);
+
+    ///Calls \c f for each neighbor of (\c i, \c j), in the order of Minesweeper::for_each_nb_in_range()
+    template<class Func> static void for_each_nb(Coord i, Coord j, Func f);
+
+private:
+    ///Cells of a chunk as bits, one word per row
+    typedef std::uint64_t Rows[chunk_size];
+
+    struct Chunk
+    {
+        Rows mines;
+        Rows visible;
+        Rows flags;
+        ///Numbers of adjacent mines, empty until computed
+        std::vector<std::uint8_t> adjacents;
+    };
+
+    std::uint64_t mSeed;
+    ///A cell is a mine if its random value is below this
+    std::uint64_t mThreshold;
+    Coord mStartr, mStartc;
+    GameState mState;
+    std::uint64_t mUncovered;
+    std::unordered_map<std::uint64_t, std::unique_ptr<Chunk>> mChunks;
+    std::vector<Position> mOpenStack;
+
+    ///Returns the key of the chunk containing (\c i, \c j)
+    static std::uint64_t p_key(Coord i, Coord j);
+
+    ///Returns the chunk containing (\c i, \c j) if it is in memory, or nullptr
+    const Chunk* p_find(Coord i, Coord j) const;
+
+    ///Returns the chunk containing (\c i, \c j), generating its mines if needed
+    Chunk& p_chunk(Coord i, Coord j);
+
+    ///Returns the chunk containing (\c i, \c j) with its numbers computed
+    Chunk& p_numbered_chunk(Coord i, Coord j);
+
+    ///Computes the numbers of the chunk containing (\c i, \c j)
+    void p_number(Chunk& c, Coord i, Coord j);
+
+    ///Makes a move at (\c i, \c j), like Minesweeper::p_open()
+    bool p_open(Coord i, Coord j);
+};
+
+template<class Func> void ChunkedMinesweeper::for_each_nb(Coord i, Coord j, Func f)
+{
+    f(i-1, j);
+    f(i-1, j-1);
+    f(i-1, j+1);
+    f(i+1, j);
+    f(i+1, j-1);
+    f(i+1, j+1);
+    f(i, j-1);
+    f(i, j+1);
+}
+
+#endif
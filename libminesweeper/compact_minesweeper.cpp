@@ -0,0 +1,255 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compact_minesweeper.h"
+
+#include <iomanip>
+
+CompactMinesweeper::CompactMinesweeper(int rows, int cols):
+    mRows(rows),
+    mCols(cols),
+    mState(GameState::uninitialized),
+    mCovered(0),
+    mMineCount(0),
+    mChordAll(false)
+{
+    if(rows <= 0 || cols <= 0)
+        throw std::out_of_range("The number of rows and columns must be positive");
+    mMines = mVisible = mFlags = BitPlane(rows, cols);
+}
+
+void CompactMinesweeper::init()
+{
+    BitPlane::count_adjacents(mMines, mAdjacents);
+    mMineCount = mMines.count();
+    mCovered = cells() - mMineCount;
+    mState = GameState::running;
+}
+
+bool CompactMinesweeper::in_range(int i, int j) const
+{
+    return 0 <= i && i < mRows && 0 <= j && j < mCols;
+}
+
+auto CompactMinesweeper::cell(int i, int j) const -> CellEntry
+{
+    //Like in Minesweeper, mines and the cells of uninitialized games have no number
+    const bool mine = mMines.get(i, j);
+    const int adjacents = mine || mState == GameState::uninitialized ? -1 : p_adjacents(i, j);
+    return CellEntry(mine, mVisible.get(i, j), adjacents, mFlags.get(i, j));
+}
+
+int CompactMinesweeper::p_adjacents(int i, int j) const
+{
+    return mAdjacents[0].get(i, j) | mAdjacents[1].get(i, j) << 1 | mAdjacents[2].get(i, j) << 2 | mAdjacents[3].get(i, j) << 3;
+}
+
+bool CompactMinesweeper::uncover(int i, int j)
+{
+    if(mVisible.get(i, j))
+        return false;
+    if(mMines.get(i, j))
+    {
+        mState = GameState::loss;
+        return false;
+    }
+    if(p_uncover(i, j) && p_adjacents(i, j) == 0)
+        p_rec_uncover(i, j);
+    return true;
+}
+
+void CompactMinesweeper::p_rec_uncover(int i, int j)
+{
+    mOpenStack.clear();
+    mOpenStack.emplace_back(i, j);
+    while(!mOpenStack.empty())
+    {
+        std::pair<int, int> c = mOpenStack.back();
+        mOpenStack.pop_back();
+        for_each_nb_in_range(c.first, c.second, [this](int k, int l)
+        {
+            if(p_uncover(k, l) && p_adjacents(k, l) == 0)
+                mOpenStack.emplace_back(k, l);
+        });
+    }
+}
+
+bool CompactMinesweeper::p_uncover(int i, int j)
+{
+    if(mVisible.get(i, j))
+        return false;
+    mVisible.set(i, j);
+    p_queue_chord(i, j);
+    if(--mCovered == 0)
+        mState = GameState::win;
+    return true;
+}
+
+void CompactMinesweeper::p_queue_chord(int i, int j)
+{
+    //Cells with 0 adjacents have all their neighbors uncovered along with them
+    if(mChordAll || !mVisible.get(i, j) || mMines.get(i, j) || p_adjacents(i, j) == 0)
+        return;
+    if(mChordQueue.size() >= max_queue())
+    {
+        mChordQueue.clear();
+        mChordAll = true;
+        return;
+    }
+    mChordQueue.push_back(std::uint64_t(i)*mCols + j);
+}
+
+void CompactMinesweeper::set_flag(int i, int j, bool flag)
+{
+    if(mFlags.get(i, j) == flag)
+        return;
+    mFlags.set(i, j, flag);
+    for_each_nb_in_range(i, j, [this](int k, int l) { p_queue_chord(k, l); });
+}
+
+bool CompactMinesweeper::uncover_if_unmarked(int i, int j)
+{
+    if(!mFlags.get(i, j))
+        return uncover(i, j);
+    else
+        return false;
+}
+
+bool CompactMinesweeper::chord(int i, int j)
+{
+    if(!mVisible.get(i, j))
+        return false;
+    //Compute the number of adjacent flagged cells
+    int markeds = 0;
+    for_each_nb_in_range(i, j, [this, &markeds](int k, int l) { markeds += mFlags.get(k, l); });
+    if(markeds != p_adjacents(i, j))
+        return false;
+    //True is returned if at least one cell has been uncovered.
+    bool ret = false;
+    for_each_nb_in_range(i, j, [this, &ret](int k, int l){ ret = uncover_if_unmarked(k, l) || ret; });
+    return ret;
+}
+
+bool CompactMinesweeper::chord_all()
+{
+    //Chording uncovers cells, which are queued in turn
+    bool ret = false;
+    while(mChordAll || !mChordQueue.empty())
+    {
+        if(mChordAll)
+        {
+            mChordAll = false;
+            for(int i = 0; i < mRows; ++i)
+            for(int j = 0; j < mCols; ++j)
+                ret = chord(i, j) || ret;
+            continue;
+        }
+        const std::uint64_t n = mChordQueue.back();
+        mChordQueue.pop_back();
+        ret = chord(int(n / mCols), int(n % mCols)) || ret;
+    }
+    return ret;
+}
+
+bool CompactMinesweeper::click(int i, int j)
+{
+    if(mVisible.get(i, j))
+        return chord(i, j);
+    else
+        return uncover_if_unmarked(i, j);
+}
+
+void CompactMinesweeper::replay()
+{
+    mVisible.clear();
+    mFlags.clear();
+    mChordQueue.clear();
+    mChordAll = false;
+    mCovered = cells() - mMineCount;
+    mState = GameState::running;
+}
+
+void CompactMinesweeper::reset()
+{
+    mMines.clear();
+    mVisible.clear();
+    mFlags.clear();
+    mChordQueue.clear();
+    mChordAll = false;
+    mState = GameState::uninitialized;
+}
+
+void CompactMinesweeper::p_print(std::ostream& os) const
+{
+    os << "   ";
+    for(int j = 0; j < mCols; ++j)
+        os << j % 10;
+    os << '\n';
+    for(int i = 0; i < mRows; ++i)
+    {
+        os << '\n' << std::setw(2) << i << ' ';
+        for(int j = 0; j < mCols; ++j)
+        {
+            if(mMines.get(i, j))
+                os << '*';
+            else if(p_adjacents(i, j) == 0)
+                os << '.';
+            else
+                os << p_adjacents(i, j);
+        }
+        os << ' ' << std::setw(2) << i;
+    }
+    os << "\n\n   ";
+    for(int j = 0; j < mCols; ++j)
+        os << j % 10;
+}
+
+std::ostream& operator<<(std::ostream& os, const CompactMinesweeper& ms)
+{
+    os << "   ";
+    for(int j = 0; j < ms.cols(); ++j)
+        os << j % 10;
+    os << '\n';
+    for(int i = 0; i < ms.rows(); ++i)
+    {
+        os << '\n' << std::setw(2) << i << ' ';
+        for(int j = 0; j < ms.cols(); ++j)
+        {
+            CompactMinesweeper::CellEntry c = ms.cell(i, j);
+            if(!c.visible())
+            {
+                if(c.flag())
+                    os << 'F';
+                else
+                    os << '?';
+            }
+            else if(c.adjacents() == 0)
+                os << '.';
+            else
+                os << c.adjacents();
+        }
+        os << ' ' << std::setw(2) << i;
+    }
+    os << "\n\n   ";
+    for(int j = 0; j < ms.cols(); ++j)
+        os << j % 10;
+
+    return os;
+}
@@ -0,0 +1,218 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPACT_MINESWEEPER_H_INCLUDED
+#define COMPACT_MINESWEEPER_H_INCLUDED
+
+#include "bitplane.h"
+#include "minesweeper.h"
+
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+/** \brief Minesweeper game state stored in bit planes
+ *
+ * The mines, the uncovered cells and the flags take one bit per cell each,
+ * the numbers of adjacent mines four more. These 7 bits per cell compare to the 6 bytes
+ * of a Minesweeper::CellEntry, so the field is about 7 times smaller, which matters for
+ * huge fields. Minesweeper also keeps a zero region index of 4 bytes per cell.
+ * The cell counts are 64 bit, so the field may have more than 2^32 cells.
+ * The game rules are the same as the ones of Minesweeper.
+ * Cells are read through cell(), which returns a Minesweeper::CellEntry by value.
+ * \note Methods beginning with \c p_ are "cheating functions".
+ */
+class CompactMinesweeper
+{
+public:
+    typedef Minesweeper::CellEntry CellEntry;
+    typedef Minesweeper::GameState GameState;
+
+    /// \throw std::out_of_range if rows or cols is negative
+    CompactMinesweeper(int rows, int cols);
+
+    /** \brief Initializes the minefield with randomly placed mines
+     * \sa Minesweeper::rand_init()
+     */
+    template<class RNG> void rand_init(std::uint64_t mines, RNG& rng, int startr = -1, int startc = -1, bool safe_nbs = false);
+
+    /** \brief Initializes the game
+     *
+     * Computes the number of covered cells and the number of adjacent mines for each cell
+     * and sets the \ref state to running.
+     */
+    void init();
+
+    ///Returns the number of rows
+    int rows() const { return mRows; }
+    ///Returns the number of columns
+    int cols() const { return mCols; }
+    ///Returns the number of cells
+    std::uint64_t cells() const { return std::uint64_t(mRows)*mCols; }
+    ///Returns the number of mines, as counted by init()
+    std::uint64_t mines() const { return mMineCount; }
+    ///Returns the number of covered cells without a mine
+    std::uint64_t covered() const { return mCovered; }
+    ///Checks if (\c i, \c j) is in range of the field
+    bool in_range(int i, int j) const;
+
+    ///Returns the current state of the game
+    GameState state() const { return mState; }
+
+    ///Returns if the game is in progress
+    bool running() const { return mState == GameState::running; }
+
+    /** \brief Returns a copy of the state of the cell (\c i, \c j).
+     *
+     * No range check is done.
+     */
+    CellEntry cell(int i, int j) const;
+
+    ///Returns if the cell (\c i, \c j) is uncovered. No range check is done.
+    bool visible(int i, int j) const { return mVisible.get(i, j); }
+    ///Returns if the cell (\c i, \c j) is flagged. No range check is done.
+    bool flagged(int i, int j) const { return mFlags.get(i, j); }
+    ///Flags or unflags the cell (\c i, \c j). No range check is done.
+    void set_flag(int i, int j, bool flag);
+
+    ///\copydoc Minesweeper::uncover()
+    bool uncover(int i, int j);
+    ///\copydoc Minesweeper::uncover_if_unmarked()
+    bool uncover_if_unmarked(int i, int j);
+    ///\copydoc Minesweeper::chord()
+    bool chord(int i, int j);
+    /** \brief Chords around all fully flagged cells
+     * \return \c true if at least one cell has been uncovered
+     *
+     * Like Minesweeper::chord_all(), this repeats until no more cells can be chorded, and only
+     * the cells which have been uncovered or had a flag change around them since the last call
+     * are examined. If there are too many of them to remember, a pass over the whole field is made instead.
+     */
+    bool chord_all();
+    ///\copydoc Minesweeper::click()
+    bool click(int i, int j);
+
+    ///Covers and unmarks all cells. The mines are left as they were.
+    void replay();
+
+    ///Resets the game into the uninitialized state
+    void reset();
+
+    ///Returns if the cell (\c i, \c j) contains a mine
+    bool p_mine(int i, int j) const { return mMines.get(i, j); }
+    ///Returns the number of mines in the cells adjacent to (\c i, \c j)
+    int p_adjacents(int i, int j) const;
+    ///Sets whether the cell (\c i, \c j) contains a mine. Has to be called before init().
+    void p_set_mine(int i, int j, bool mine) { mMines.set(i, j, mine); }
+
+    ///Prints out the field, including the covered cells
+    void p_print(std::ostream& os) const;
+
+    /** \brief Calls \c f for each neighbor of (\c i, \c j) in the field
+     *
+     * The neighbors are visited in the same order as by Minesweeper::for_each_nb_in_range().
+     */
+    template<class Func> void for_each_nb_in_range(int i, int j, Func f) const;
+
+private:
+    int mRows, mCols;
+    BitPlane mMines;
+    BitPlane mVisible;
+    BitPlane mFlags;
+    ///The numbers of adjacent mines in binary
+    BitPlane mAdjacents[4];
+    GameState mState;
+    ///The number of covered fields
+    std::uint64_t mCovered;
+    ///The number of mines, as counted by init()
+    std::uint64_t mMineCount;
+    ///Stack of cells whose neighbors still have to be uncovered by p_rec_uncover()
+    std::vector<std::pair<int, int>> mOpenStack;
+    /** \brief Uncovered numbered cells which might have become chordable since the last chord_all(),
+     * as row times cols plus column
+     *
+     * A cell can be listed more than once. So that the queue stays small compared to the bit
+     * planes, it is dropped and mChordAll is set once it holds more than max_queue() cells.
+     */
+    std::vector<std::uint64_t> mChordQueue;
+    ///Whether every cell has to be examined by the next chord_all()
+    bool mChordAll;
+
+    ///Returns the largest number of cells mChordQueue holds, about 2 bits per cell
+    std::uint64_t max_queue() const { return std::max<std::uint64_t>(cells() / 32, 1024); }
+
+    ///Adds the cell (\c i, \c j) to mChordQueue if it is an uncovered number
+    void p_queue_chord(int i, int j);
+
+    ///Uncovers the opening around the zero cell (\c i, \c j)
+    void p_rec_uncover(int i, int j);
+
+    /** \brief Uncovers the cell (\c i, \c j).
+     * \return \c true if the cell was not covered before.
+     */
+    bool p_uncover(int i, int j);
+};
+
+///Prints out the field
+std::ostream& operator<<(std::ostream& os, const CompactMinesweeper& ms);
+
+template<class RNG> void CompactMinesweeper::rand_init(std::uint64_t mines, RNG& rng, int startr, int startc, bool safe_nbs)
+{
+    if(mState != GameState::uninitialized)
+        throw std::runtime_error("The field has already been initialized");
+
+    Minesweeper::sample_cells(mRows, mCols, mines, rng, startr, startc, safe_nbs, [this](int i, int j)
+    {
+        if(mMines.get(i, j))
+            return false;
+        mMines.set(i, j);
+        return true;
+    });
+
+    init();
+}
+
+template<class Func> void CompactMinesweeper::for_each_nb_in_range(int i, int j, Func f) const
+{
+    if(i > 0)
+    {
+        f(i-1, j);
+        if(j > 0)
+            f(i-1, j-1);
+        if(j < mCols-1)
+            f(i-1, j+1);
+    }
+    if(i < mRows-1)
+    {
+        f(i+1, j);
+        if(j > 0)
+            f(i+1, j-1);
+        if(j < mCols-1)
+            f(i+1, j+1);
+    }
+    if(j > 0)
+        f(i, j-1);
+    if(j < mCols-1)
+        f(i, j+1);
+}
+
+#endif
@@ -0,0 +1,196 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "concurrent_minesweeper.h"
+
+#include <stdexcept>
+
+ConcurrentMinesweeper::ConcurrentMinesweeper(const Minesweeper& ms):
+    mRows(ms.rows()),
+    mCols(ms.cols()),
+    mMines(ms.mines()),
+    mMineBits((ms.cells() + 63) / 64, 0),
+    mAdjacents(ms.cells(), 0),
+    mVisible((ms.cells() + 63) / 64),
+    mFlags((ms.cells() + 63) / 64),
+    mCovered(0),
+    mState(ms.state())
+{
+    if(ms.state() == GameState::uninitialized)
+        throw std::invalid_argument("The game has to be initialized");
+
+    std::vector<std::uint64_t> visible(mVisible.size(), 0), flags(mFlags.size(), 0);
+    unsigned int covered = 0;
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        const Minesweeper::CellEntry& c = ms.cell(i, j);
+        const int n = i*mCols + j;
+        const std::uint64_t bit = std::uint64_t(1) << (n % 64);
+        if(c.p_mine())
+            mMineBits[n / 64] |= bit;
+        else
+        {
+            mAdjacents[n] = c.p_adjacents();
+            covered += !c.visible();
+        }
+        if(c.visible())
+            visible[n / 64] |= bit;
+        if(c.flag())
+            flags[n / 64] |= bit;
+    }
+    for(std::size_t w = 0; w < mVisible.size(); ++w)
+    {
+        mVisible[w].store(visible[w], std::memory_order_relaxed);
+        mFlags[w].store(flags[w], std::memory_order_relaxed);
+    }
+    mCovered.store(covered);
+}
+
+auto ConcurrentMinesweeper::cell(int i, int j) const -> CellEntry
+{
+    return CellEntry(p_mine(i, j), visible(i, j), p_mine(i, j) ? -1 : p_adjacents(i, j), flagged(i, j));
+}
+
+bool ConcurrentMinesweeper::uncover(int i, int j)
+{
+    return p_open(i, j, nullptr);
+}
+
+bool ConcurrentMinesweeper::uncover_if_unmarked(int i, int j)
+{
+    if(!flagged(i, j))
+        return uncover(i, j);
+    else
+        return false;
+}
+
+bool ConcurrentMinesweeper::chord(int i, int j)
+{
+    return p_chord(i, j, nullptr);
+}
+
+bool ConcurrentMinesweeper::click(int i, int j)
+{
+    if(visible(i, j))
+        return p_chord(i, j, nullptr);
+    else if(!flagged(i, j))
+        return p_open(i, j, nullptr);
+    else
+        return false;
+}
+
+bool ConcurrentMinesweeper::click(int i, int j, std::vector<Position>& delta)
+{
+    if(visible(i, j))
+        return p_chord(i, j, &delta);
+    else if(!flagged(i, j))
+        return p_open(i, j, &delta);
+    else
+        return false;
+}
+
+void ConcurrentMinesweeper::set_flag(int i, int j, bool flag)
+{
+    const int n = i*mCols + j;
+    const std::uint64_t bit = std::uint64_t(1) << (n % 64);
+    if(flag)
+        mFlags[n / 64].fetch_or(bit, std::memory_order_acq_rel);
+    else
+        mFlags[n / 64].fetch_and(~bit, std::memory_order_acq_rel);
+}
+
+void ConcurrentMinesweeper::toggle_flag(int i, int j)
+{
+    const int n = i*mCols + j;
+    mFlags[n / 64].fetch_xor(std::uint64_t(1) << (n % 64), std::memory_order_acq_rel);
+}
+
+bool ConcurrentMinesweeper::p_open(int i, int j, std::vector<Position>* delta)
+{
+    if(!running() || visible(i, j))
+        return false;
+    if(p_mine(i, j))
+    {
+        p_finish(GameState::loss);
+        return false;
+    }
+
+    //The cells claimed by this call whose neighbors still have to be uncovered. The stack
+    //of each thread keeps its capacity, so openings don't allocate once it has grown.
+    thread_local std::vector<Position> stack;
+    stack.clear();
+    auto take = [this, delta](int k, int l)
+    {
+        if(!p_claim(k*mCols + l))
+            return false;
+        if(delta)
+            delta->emplace_back(k, l);
+        if(p_adjacents(k, l) == 0)
+            stack.emplace_back(k, l);
+        return true;
+    };
+    //Another thread may have uncovered the cell in the meantime
+    if(!take(i, j))
+        return false;
+    while(!stack.empty() && running())
+    {
+        const Position p = stack.back();
+        stack.pop_back();
+        for_each_nb_in_range(p.first, p.second, take);
+    }
+    return true;
+}
+
+bool ConcurrentMinesweeper::p_claim(int n)
+{
+    const std::uint64_t bit = std::uint64_t(1) << (n % 64);
+    if(mVisible[n / 64].fetch_or(bit, std::memory_order_acq_rel) & bit)
+        return false;
+    if(mCovered.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        p_finish(GameState::win);
+    return true;
+}
+
+bool ConcurrentMinesweeper::p_chord(int i, int j, std::vector<Position>* delta)
+{
+    if(!running() || !visible(i, j))
+        return false;
+    //Compute the number of adjacent flagged cells
+    int markeds = 0;
+    for_each_nb_in_range(i, j, [this, &markeds](int k, int l) { markeds += flagged(k, l); });
+    if(markeds != p_adjacents(i, j))
+        return false;
+    //True is returned if at least one cell has been uncovered.
+    bool ret = false;
+    for_each_nb_in_range(i, j, [this, delta, &ret](int k, int l)
+    {
+        if(!flagged(k, l))
+            ret = p_open(k, l, delta) || ret;
+    });
+    return ret;
+}
+
+void ConcurrentMinesweeper::p_finish(GameState to)
+{
+    GameState expected = GameState::running;
+    mState.compare_exchange_strong(expected, to);
+}
@@ -0,0 +1,167 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CONCURRENT_MINESWEEPER_H_INCLUDED
+#define CONCURRENT_MINESWEEPER_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/** \brief Minesweeper game which many threads can play at the same time
+ *
+ * The mines and numbers are fixed when the game is created, so they are read without
+ * synchronization. The uncovered cells and the flags are bit planes of atomic words.
+ * A cell is uncovered by atomically setting its bit, and only the thread which set it
+ * counts it and continues an opening from it. So overlapping moves of several threads
+ * uncover each cell exactly once, and no locks are taken.
+ *
+ * The number of covered cells is an atomic counter, and the game is won by the move which
+ * brings it to zero. The first move which wins or loses ends the game, later ones do nothing.
+ * Moves which are in progress when the game ends may still uncover some cells.
+ */
+class ConcurrentMinesweeper
+{
+public:
+    typedef Minesweeper::CellEntry CellEntry;
+    typedef Minesweeper::GameState GameState;
+    typedef Minesweeper::Position Position;
+
+    /** \brief Creates a game with the mines, uncovered cells and flags of \c ms
+     * \throw std::invalid_argument if \c ms has not been \ref Minesweeper::init "init'ed"
+     */
+    explicit ConcurrentMinesweeper(const Minesweeper& ms);
+
+    ConcurrentMinesweeper(const ConcurrentMinesweeper&) = delete;
+    ConcurrentMinesweeper& operator=(const ConcurrentMinesweeper&) = delete;
+
+    ///Returns the number of rows
+    int rows() const { return mRows; }
+    ///Returns the number of columns
+    int cols() const { return mCols; }
+    ///Returns the number of cells
+    unsigned int cells() const { return mRows*mCols; }
+    ///Returns the number of mines
+    unsigned int mines() const { return mMines; }
+    ///Checks if (\c i, \c j) is in range of the field
+    bool in_range(int i, int j) const { return 0 <= i && i < mRows && 0 <= j && j < mCols; }
+
+    ///Returns the current state of the game
+    GameState state() const { return mState.load(); }
+    ///Returns if the game is in progress
+    bool running() const { return state() == GameState::running; }
+    ///Returns the number of covered cells without a mine
+    unsigned int covered() const { return mCovered.load(); }
+
+    ///Returns a copy of the state of the cell (\c i, \c j). No range check is done.
+    CellEntry cell(int i, int j) const;
+    ///Returns if the cell (\c i, \c j) is uncovered. No range check is done.
+    bool visible(int i, int j) const { return p_get(mVisible, i*mCols + j); }
+    ///Returns if the cell (\c i, \c j) is flagged. No range check is done.
+    bool flagged(int i, int j) const { return p_get(mFlags, i*mCols + j); }
+
+    ///\copydoc Minesweeper::uncover()
+    bool uncover(int i, int j);
+    ///\copydoc Minesweeper::uncover_if_unmarked()
+    bool uncover_if_unmarked(int i, int j);
+    ///\copydoc Minesweeper::chord()
+    bool chord(int i, int j);
+    ///\copydoc Minesweeper::click()
+    bool click(int i, int j);
+
+    /** \brief Like click(), appending the positions of the cells uncovered by this call to \c delta
+     *
+     * Cells uncovered by other threads at the same time are not included.
+     */
+    bool click(int i, int j, std::vector<Position>& delta);
+
+    ///Flags or unflags the cell (\c i, \c j)
+    void set_flag(int i, int j, bool flag);
+    ///Toggles the flag of the cell (\c i, \c j)
+    void toggle_flag(int i, int j);
+
+    ///Returns if the cell (\c i, \c j) contains a mine
+    bool p_mine(int i, int j) const { return mMineBits[(i*mCols + j) / 64] >> ((i*mCols + j) % 64) & 1; }
+    ///Returns the number of mines in the cells adjacent to (\c i, \c j)
+    int p_adjacents(int i, int j) const { return mAdjacents[i*mCols + j]; }
+
+private:
+    typedef std::atomic<std::uint64_t> Word;
+
+    int mRows, mCols;
+    unsigned int mMines;
+    std::vector<std::uint64_t> mMineBits;
+    std::vector<std::uint8_t> mAdjacents;
+    std::vector<Word> mVisible;
+    std::vector<Word> mFlags;
+    std::atomic<unsigned int> mCovered;
+    std::atomic<GameState> mState;
+
+    static bool p_get(const std::vector<Word>& plane, int n)
+    {
+        return plane[n / 64].load(std::memory_order_acquire) >> (n % 64) & 1;
+    }
+
+    /** \brief Makes a move at (\c i, \c j), like Minesweeper::p_open()
+     * \param delta Receives the uncovered cells if not \c nullptr
+     */
+    bool p_open(int i, int j, std::vector<Position>* delta);
+
+    /** \brief Claims the cell \c n by setting its bit in mVisible
+     * \return \c true if this call has uncovered it
+     */
+    bool p_claim(int n);
+
+    bool p_chord(int i, int j, std::vector<Position>* delta);
+
+    ///Changes the state from running to \c to, unless the game has already ended
+    void p_finish(GameState to);
+
+    template<class Func> void for_each_nb_in_range(int i, int j, Func f) const;
+};
+
+template<class Func> void ConcurrentMinesweeper::for_each_nb_in_range(int i, int j, Func f) const
+{
+    if(i > 0)
+    {
+        f(i-1, j);
+        if(j > 0)
+            f(i-1, j-1);
+        if(j < mCols-1)
+            f(i-1, j+1);
+    }
+    if(i < mRows-1)
+    {
+        f(i+1, j);
+        if(j > 0)
+            f(i+1, j-1);
+        if(j < mCols-1)
+            f(i+1, j+1);
+    }
+    if(j > 0)
+        f(i, j-1);
+    if(j < mCols-1)
+        f(i, j+1);
+}
+
+#endif
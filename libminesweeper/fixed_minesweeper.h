@@ -0,0 +1,110 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FIXED_MINESWEEPER_H_INCLUDED
+#define FIXED_MINESWEEPER_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <array>
+
+/** \brief Storage of FixedMinesweeper
+ *
+ * This is a separate base class so that the storage is constructed before the Minesweeper base.
+ * It holds the cells including the border ring and all lists of the game, sized for the worst case,
+ * see Minesweeper::Buffers.
+ */
+template<int Rows, int Cols> class FixedMinesweeperStorage
+{
+protected:
+    ///Number of cells including the border ring
+    static constexpr int padded = (Rows+2)*(Cols+2);
+
+    std::array<Minesweeper::CellEntry, padded> mFixedCells;
+    std::array<int, padded> mFixedRegion;
+    std::array<int, padded + 1> mFixedRegionStart;
+    std::array<int, 4*padded> mFixedRegionCells;
+    std::array<int, padded> mFixedOpenStack;
+    std::array<int, padded> mFixedChordQueue;
+    std::array<int, padded> mFixedTouched;
+    std::array<int, padded> mFixedMineCells;
+};
+
+/** \brief Minesweeper game state with the field size fixed at compile time
+ *
+ * The cells, the zero region index, the chord queue and the lists of touched cells and mines
+ * are stored inside the object, so neither creating nor playing a game allocates memory.
+ * The dimensions are constexpr, and the functions visiting the neighbors of cells are compiled
+ * for the stride of the rows, so that their offsets are constants and the loops are unrolled.
+ *
+ * The game logic is the one of Minesweeper, and as a Minesweeper it can be used with Solver,
+ * ProbabilityEngine, MoveJournal, Snapshot and the like. Copying it into a Minesweeper allocates
+ * storage for the copy. Assigning a Minesweeper to it is meant for games of the same size;
+ * a game with more cells including the border throws std::length_error.
+ */
+template<int Rows, int Cols> class FixedMinesweeper : private FixedMinesweeperStorage<Rows, Cols>, public Minesweeper
+{
+public:
+    static_assert(Rows > 0 && Cols > 0, "The number of rows and columns must be positive");
+
+    FixedMinesweeper():
+        Minesweeper(Rows, Cols, p_buffers(*this), p_kernels<Cols+2>())
+    {}
+
+    FixedMinesweeper(const FixedMinesweeper& other):
+        FixedMinesweeper()
+    {
+        Minesweeper::operator=(other);
+    }
+
+    FixedMinesweeper& operator=(const FixedMinesweeper& other)
+    {
+        Minesweeper::operator=(other);
+        return *this;
+    }
+
+    ///Returns the number of rows
+    static constexpr int rows() { return Rows; }
+    ///Returns the number of columns
+    static constexpr int cols() { return Cols; }
+    ///Returns the number of cells
+    static constexpr unsigned int cells() { return Rows*Cols; }
+
+private:
+    ///Returns the arrays of \c s, whose storage is constructed before the Minesweeper base
+    static Buffers p_buffers(FixedMinesweeper& s)
+    {
+        const Buffers b = {
+            s.mFixedCells.data(), s.mFixedRegion.data(), s.mFixedRegionStart.data(),
+            s.mFixedRegionCells.data(), s.mFixedOpenStack.data(), s.mFixedChordQueue.data(),
+            s.mFixedTouched.data(), s.mFixedMineCells.data()
+        };
+        return b;
+    }
+};
+
+///Beginner field with 9 rows and 9 columns
+typedef FixedMinesweeper<9, 9> BeginnerMinesweeper;
+///Intermediate field with 16 rows and 16 columns
+typedef FixedMinesweeper<16, 16> IntermediateMinesweeper;
+///Expert field with 16 rows and 30 columns
+typedef FixedMinesweeper<16, 30> ExpertMinesweeper;
+
+#endif
@@ -0,0 +1,193 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "generator.h"
+#include "seeded_layout.h"
+#include "solver.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+NoGuessGenerator::NoGuessGenerator(int rows, int cols, unsigned int mines, int startr, int startc, ThreadPool* pool):
+    mRows(rows), mCols(cols), mMines(mines), mStartr(startr), mStartc(startc),
+    mPool(pool),
+    mRepairs(0),
+    mMaxAttempts(UINT64_MAX),
+    mStats()
+{
+    if(rows <= 0 || cols <= 0)
+        throw std::out_of_range("The number of rows and columns must be positive");
+    if(startr < 0 || startr >= rows || startc < 0 || startc >= cols)
+        throw std::out_of_range("The starting position must be in range of the field");
+    unsigned int start_area = 0;
+    for(int i = startr-1; i <= startr+1; ++i)
+    for(int j = startc-1; j <= startc+1; ++j)
+        start_area += i >= 0 && i < rows && j >= 0 && j < cols;
+    if(mines > std::uint64_t(rows)*cols - start_area)
+        throw std::out_of_range("The number of mines must be smaller than the number of cells outside the starting area");
+}
+
+std::vector<Minesweeper> NoGuessGenerator::generate(std::size_t count, std::uint64_t seed)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    mStats = Stats();
+    mStats.threads = mPool ? mPool->size() : 1;
+
+    //A few attempts per thread and batch, so that unlucky attempts are balanced
+    const std::size_t batch = mStats.threads * 4;
+    std::vector<std::unique_ptr<Minesweeper>> fields(batch);
+    std::vector<Outcome> outcomes(batch);
+    std::vector<Minesweeper> result;
+    while(result.size() < count && mStats.attempts < mMaxAttempts)
+    {
+        const std::uint64_t first = mStats.attempts;
+        const std::size_t size = std::min<std::uint64_t>(batch, mMaxAttempts - first);
+        auto attempt = [&](std::size_t t)
+        {
+            if(!fields[t])
+                fields[t].reset(new Minesweeper(mRows, mCols));
+            outcomes[t] = p_attempt(*fields[t], seed, first + t);
+        };
+        if(mPool)
+            mPool->run(size, attempt);
+        else
+        {
+            for(std::size_t t = 0; t < size; ++t)
+                attempt(t);
+        }
+        mStats.attempts += size;
+
+        //Take the fields in the order of the attempts
+        for(std::size_t t = 0; t < size; ++t)
+        {
+            if(outcomes[t] == failed)
+                continue;
+            ++mStats.successes;
+            mStats.repaired += outcomes[t] == solved_repaired;
+            if(result.size() < count)
+            {
+                fields[t]->replay();
+                result.push_back(std::move(*fields[t]));
+                fields[t].reset();
+            }
+        }
+    }
+
+    mStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return result;
+}
+
+auto NoGuessGenerator::p_attempt(Minesweeper& ms, std::uint64_t seed, std::uint64_t attempt) const -> Outcome
+{
+    const std::uint64_t id = SeededLayout::game_id(seed, attempt);
+    ms.reset();
+    SeededLayout(mRows, mCols, mMines, id, mStartr, mStartc, true).apply(ms);
+    CounterRng rng(id, 1);
+
+    std::vector<Minesweeper::Position> undecided;
+    for(unsigned int r = 0; ; ++r)
+    {
+        if(p_solve(ms, undecided))
+            return r == 0 ? solved : solved_repaired;
+        if(r == mRepairs || !p_repair(ms, undecided, rng))
+            return failed;
+    }
+}
+
+bool NoGuessGenerator::p_solve(Minesweeper& ms, std::vector<Minesweeper::Position>& undecided) const
+{
+    Solver solver(ms);
+    std::vector<Minesweeper::Position> delta;
+    ms.uncover(mStartr, mStartc, delta);
+    solver.update(delta);
+    while(ms.running() && solver.solve())
+    {
+        delta.clear();
+        for(const Minesweeper::Position& p: solver.safe_cells())
+            ms.uncover(p.first, p.second, delta);
+        solver.update(delta);
+    }
+    if(ms.state() == Minesweeper::GameState::win)
+        return true;
+
+    undecided.clear();
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        if(!ms.cell(i, j).p_mine() || solver.known_mine(i, j))
+            continue;
+        bool frontier = false;
+        ms.for_each_nb_in_range(i, j, [&](int k, int l) { frontier |= ms.cell(k, l).visible(); });
+        if(frontier)
+            undecided.emplace_back(i, j);
+    }
+    return false;
+}
+
+bool NoGuessGenerator::p_repair(Minesweeper& ms, const std::vector<Minesweeper::Position>& undecided, CounterRng& rng) const
+{
+    if(undecided.empty())
+        return false;
+
+    //Covered cells which are not next to the uncovered area, so that the moved mine does not add to
+    //an uncovered number. The numbers around the undecided mine change though, so the game is
+    //initialized again with all cells covered and p_attempt() plays it from the start.
+    std::vector<Minesweeper::Position> targets;
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        if(ms.cell(i, j).visible() || ms.cell(i, j).p_mine() || p_in_start_area(i, j))
+            continue;
+        bool frontier = false;
+        ms.for_each_nb_in_range(i, j, [&](int k, int l) { frontier |= ms.cell(k, l).visible(); });
+        if(!frontier)
+            targets.emplace_back(i, j);
+    }
+    if(targets.empty())
+        return false;
+
+    const Minesweeper::Position from = undecided[rng() % undecided.size()];
+    const Minesweeper::Position to = targets[rng() % targets.size()];
+
+    std::vector<Minesweeper::Position> mines;
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        if(ms.cell(i, j).p_mine())
+            mines.emplace_back(i, j);
+    }
+    ms.reset();
+    for(const Minesweeper::Position& p: mines)
+        ms.cell(p.first, p.second).p_set_mine(true);
+    ms.cell(from.first, from.second).p_set_mine(false);
+    ms.cell(to.first, to.second).p_set_mine(true);
+    ms.init();
+    return true;
+}
+
+bool NoGuessGenerator::p_in_start_area(int i, int j) const
+{
+    return std::abs(i - mStartr) <= 1 && std::abs(j - mStartc) <= 1;
+}
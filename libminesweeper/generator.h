@@ -0,0 +1,126 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef GENERATOR_H_INCLUDED
+#define GENERATOR_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <cstdint>
+#include <vector>
+
+class CounterRng;
+class ThreadPool;
+
+/** \brief Generates fields which can be solved from the starting position without guessing
+ *
+ * Candidate layouts are drawn at random, leaving the starting cell
+ * and its neighbors free, and played by the Solver from the starting position. If the Solver
+ * gets stuck, the layout can be repaired by moving a mine which the Solver could not decide
+ * on to a covered cell away from the uncovered area, and playing it again.
+ *
+ * Attempt number \c a starts from the SeededLayout with ID SeededLayout::game_id(seed, a),
+ * and the fields of the first successful attempts are returned. So the result only depends
+ * on the seed, not on the number of threads.
+ */
+class NoGuessGenerator
+{
+public:
+    ///Statistics of a call to generate()
+    struct Stats
+    {
+        ///Number of candidate layouts drawn
+        std::uint64_t attempts;
+        ///Number of candidates which have been solved, including those not returned
+        std::uint64_t successes;
+        ///Number of successful candidates which needed repairs
+        std::uint64_t repaired;
+        ///Wall clock time in seconds
+        double seconds;
+        ///Number of threads used
+        unsigned int threads;
+
+        ///Returns the number of solvable fields found per second
+        double fields_per_second() const { return seconds > 0.0 ? successes / seconds : 0.0; }
+        ///Returns the number of solvable fields found per second and thread
+        double fields_per_second_per_thread() const { return fields_per_second() / threads; }
+    };
+
+    /** \brief Creates a generator for fields of the given size
+     * \param pool Threads to use for generating, or \c nullptr to generate in the calling thread.
+     * It has to outlive the generator.
+     * \throw std::out_of_range if the field size is invalid, (\c startr, \c startc) is not in
+     * range or there are not enough cells outside of the starting area
+     */
+    NoGuessGenerator(int rows, int cols, unsigned int mines, int startr, int startc, ThreadPool* pool = nullptr);
+
+    ///Sets how many times a stuck layout is repaired before it is given up. The default is 0.
+    void set_repairs(unsigned int repairs) { mRepairs = repairs; }
+
+    ///Sets after how many attempts generate() gives up. The default is unlimited.
+    void set_max_attempts(std::uint64_t attempts) { mMaxAttempts = attempts; }
+
+    /** \brief Generates fields which can be solved without guessing
+     * \param count The number of fields wanted
+     * \param seed Seed of the layouts
+     * \return The fields, running and with all cells covered. The game is started by
+     * uncovering the starting position. There are fewer than \c count fields only if
+     * the maximal number of attempts has been reached.
+     */
+    std::vector<Minesweeper> generate(std::size_t count, std::uint64_t seed);
+
+    ///Returns the statistics of the last call to generate()
+    const Stats& stats() const { return mStats; }
+
+private:
+    const int mRows, mCols;
+    const unsigned int mMines;
+    const int mStartr, mStartc;
+    ThreadPool* mPool;
+    unsigned int mRepairs;
+    std::uint64_t mMaxAttempts;
+    Stats mStats;
+
+    ///Outcome of one attempt
+    enum Outcome
+    {
+        failed,
+        solved,
+        solved_repaired
+    };
+
+    ///Draws the layout of attempt \c attempt into \c ms and tries to make it solvable
+    Outcome p_attempt(Minesweeper& ms, std::uint64_t seed, std::uint64_t attempt) const;
+
+    /** \brief Plays \c ms from the starting position with the Solver
+     * \param undecided Receives the covered mines next to uncovered cells the Solver could not decide on
+     * \return \c true if the game has been won
+     */
+    bool p_solve(Minesweeper& ms, std::vector<Minesweeper::Position>& undecided) const;
+
+    ///Moves a mine from \c undecided to a cell away from the uncovered area, and initializes \c ms again with all cells covered
+    bool p_repair(Minesweeper& ms, const std::vector<Minesweeper::Position>& undecided, CounterRng& rng) const;
+
+    ///Checks if (\c i, \c j) is the starting position or next to it
+    bool p_in_start_area(int i, int j) const;
+};
+
+#endif
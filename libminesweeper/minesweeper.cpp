@@ -19,8 +19,12 @@
 */
 
 #include "minesweeper.h"
+#include "move_journal.h"
+#include "seeded_layout.h"
 
+#include <algorithm>
 #include <iomanip>
+#include <utility>
 
 int Minesweeper::CellEntry::adjacents() const
 {
@@ -30,41 +34,132 @@ int Minesweeper::CellEntry::adjacents() const
         return -1;
 }
 
+Minesweeper::CellEntry::CellEntry():
+    mFlag(false),
+    mMine(false),
+    mVisible(false),
+    mQueued(false),
+    mTouched(false),
+    mAdjacents(-1)
+{}
+
 Minesweeper::CellEntry::CellEntry(bool mine, bool visible, int adjacents, bool flag):
-    flag(flag),
+    mFlag(flag),
     mMine(mine),
     mVisible(visible),
+    mQueued(false),
+    mTouched(false),
     mAdjacents(adjacents)
 {}
 
 Minesweeper::Minesweeper(int rows, int cols):
     mRows(rows),
     mCols(cols),
-    mData(rows*cols, CellEntry()),
-    mState(GameState::uninitialized)
+    mStride(cols+2),
+    mKernels(&p_kernels<0>()),
+    mState(GameState::uninitialized),
+    mCovered(0),
+    mMines(0),
+    mDelta(nullptr),
+    mJournal(nullptr),
+    mHash(0)
+{
+    p_check_size(rows, cols);
+    mData.resize(p_padded(rows, cols));
+    p_init_cells();
+}
+
+Minesweeper::Minesweeper(int rows, int cols, const Buffers& buffers, const Kernels& kernels):
+    mData(buffers.cells, p_padded(rows, cols)),
+    mRows(rows),
+    mCols(cols),
+    mStride(cols+2),
+    mKernels(&kernels),
+    mState(GameState::uninitialized),
+    mCovered(0),
+    mMines(0),
+    mRegion(buffers.region, p_padded(rows, cols)),
+    mRegionStart(buffers.region_start, p_padded(rows, cols) + 1),
+    mRegionCells(buffers.region_cells, 4*p_padded(rows, cols)),
+    mOpenStack(buffers.open_stack, p_padded(rows, cols)),
+    mChordQueue(buffers.chord_queue, p_padded(rows, cols)),
+    mDelta(nullptr),
+    mJournal(nullptr),
+    mTouched(buffers.touched, p_padded(rows, cols)),
+    mMineCells(buffers.mine_cells, p_padded(rows, cols)),
+    mHash(0)
+{
+    p_check_size(rows, cols);
+    mData.resize(p_padded(rows, cols));
+    p_init_cells();
+}
+
+void Minesweeper::p_check_size(int rows, int cols)
 {
     if(rows <= 0 || cols <= 0)
         throw std::out_of_range("The number of rows and columns must be positive");
+    if((std::int64_t(rows) + 2)*(std::int64_t(cols) + 2) > std::numeric_limits<int>::max())
+        throw std::length_error("The field is too large for Minesweeper, use CompactMinesweeper");
 }
 
-void Minesweeper::init()
+std::uint64_t Minesweeper::p_zobrist(int n, int what)
 {
-    unsigned int mines = 0;
+    //The keys are computed instead of being stored, which would take ten per cell
+    return splitmix64(std::uint64_t(n) << 4 | what);
+}
+
+void Minesweeper::p_init_cells()
+{
+    for(std::size_t n = 0; n < mData.size(); ++n)
+    {
+        mData[n] = CellEntry(false, true, -1, false);
+        mData[n].mQueued = true;
+    }
     for(int i = 0; i < mRows; ++i)
     for(int j = 0; j < mCols; ++j)
+        cell(i, j) = CellEntry();
+}
+
+void Minesweeper::p_reshape(int rows, int cols)
+{
+    p_check_size(rows, cols);
+    mRows = rows;
+    mCols = cols;
+    mStride = cols+2;
+    mData.resize(p_padded(rows, cols));
+    p_init_cells();
+    mKernels = &p_kernels<0>();
+    mState = GameState::uninitialized;
+    mCovered = 0;
+    mMines = 0;
+    mRegion.clear();
+    mRegionStart.clear();
+    mRegionCells.clear();
+    mChordQueue.clear();
+    mTouched.clear();
+    mMineCells.clear();
+    mHash = 0;
+}
+
+void Minesweeper::init()
+{
+    (this->*mKernels->count_adjacents)();
+    mMines = mMineCells.size();
+    mCovered = cells() - mMines;
+    //Cells uncovered or flagged before only now have numbers to show
+    mHash = 0;
+    for(int n: mTouched)
     {
-        if(cell(i, j).mMine)
+        if(mData[n].mVisible && !mData[n].mMine)
         {
-            ++mines;
-            continue;
+            p_hash(n, mData[n].mAdjacents);
+            p_queue_chord(n);
+            --mCovered;
         }
-        //Compute the number of mines in the neighbor fields
-        int adj = 0;
-        for_each_nb_in_range(i, j, [&](int k, int l)
-            { adj += try_get_cell(k, l).mMine; });
-        cell(i, j).mAdjacents = adj;
+        if(mData[n].mFlag)
+            p_hash(n, flag_key);
     }
-    mCovered = cells() - mines;
+    (this->*mKernels->build_regions)();
     mState = GameState::running;
 }
 
@@ -75,12 +170,12 @@ bool Minesweeper::in_range(int i, int j) const
 
 auto Minesweeper::cell(int i, int j) -> CellEntry&
 {
-    return mData[i*mCols + j];
+    return mData[index(i, j)];
 }
 
 auto Minesweeper::cell(int i, int j) const -> const CellEntry&
 {
-    return mData[i*mCols + j];
+    return mData[index(i, j)];
 }
 
 auto Minesweeper::try_get_cell(int i, int j) const -> CellEntry
@@ -93,47 +188,69 @@ auto Minesweeper::try_get_cell(int i, int j) const -> CellEntry
 
 bool Minesweeper::uncover(int i, int j)
 {
-    if(cell(i, j).mVisible)
+    return p_open(index(i, j));
+}
+
+bool Minesweeper::p_open(int n)
+{
+    if(mData[n].mVisible)
         return false;
-    if(cell(i, j).mMine)
+    if(mData[n].mMine)
     {
         mState = GameState::loss;
         return false;
     }
-    if(p_uncover(i, j) && cell(i, j).mAdjacents == 0)
-        p_rec_uncover();
+    if(p_uncover(n) && mData[n].mAdjacents == 0)
+        p_uncover_region(mRegion[n]);
     return true;
 }
 
-void Minesweeper::p_rec_uncover()
+void Minesweeper::p_uncover_region(int region)
 {
-    bool cont;
-    do
-    {
-        cont = false;
-        for(int i = 0; i < mRows; ++i)
-        for(int j = 0; j < mCols; ++j)
-        {
-            if(!cell(i, j).mVisible || cell(i, j).mAdjacents != 0)
-                continue;
-            for_each_nb_in_range(i, j, [&](int k, int l){ cont = p_uncover(k, l) || cont; });
-        }
-    } while(cont);
+    for(int k = mRegionStart[region]; k < mRegionStart[region+1]; ++k)
+        p_uncover(mRegionCells[k]);
 }
 
-bool Minesweeper::p_uncover(int i, int j)
+bool Minesweeper::p_uncover(int n)
 {
-    if(cell(i, j).mVisible)
+    if(mData[n].mVisible)
         return false;
-    cell(i, j).mVisible = true;
+    mData[n].mVisible = true;
+    p_hash(n, mData[n].mAdjacents);
+    p_touch(n);
+    p_queue_chord(n);
+    if(mJournal)
+        mJournal->p_note(n, MoveJournal::uncovered);
+    if(mDelta)
+        mDelta->emplace_back(n / mStride - 1, n % mStride - 1);
     if(--mCovered == 0)
         mState = GameState::win;
     return true;
 }
 
+void Minesweeper::p_queue_chord(int n)
+{
+    //Cells with 0 adjacents have all their neighbors uncovered along with them
+    CellEntry& c = mData[n];
+    if(c.mQueued || !c.mVisible || c.mAdjacents <= 0)
+        return;
+    c.mQueued = true;
+    mChordQueue.push_back(n);
+    if(mJournal)
+        mJournal->p_note(n, MoveJournal::queued);
+}
+
+void Minesweeper::p_touch(int n)
+{
+    if(mData[n].mTouched)
+        return;
+    mData[n].mTouched = true;
+    mTouched.push_back(n);
+}
+
 bool Minesweeper::uncover_if_unmarked(int i, int j)
 {
-    if(!cell(i, j).flag)
+    if(!cell(i, j).mFlag)
         return uncover(i, j);
     else
         return false;
@@ -141,30 +258,43 @@ bool Minesweeper::uncover_if_unmarked(int i, int j)
 
 bool Minesweeper::chord(int i, int j)
 {
-    if(!cell(i, j).mVisible)
-        return false;
-    //Compute the number of adjacent flagged cells
-    int markeds = 0;
-    for_each_nb_in_range(i, j, [this, &markeds](int k, int l) { markeds += cell(k, l).flag; });
-    if(markeds != cell(i, j).mAdjacents)
-        return false;
-    //True is returned if at least one cell has been uncovered.
-    bool ret = false;
-    for_each_nb_in_range(i, j, [this, &ret](int k, int l){ ret = uncover_if_unmarked(k, l) || ret; });
-    return ret;
+    return (this->*mKernels->chord)(index(i, j));
 }
 
 bool Minesweeper::chord_all()
 {
+    //Chording uncovers cells, which are queued in turn
     bool ret = false;
-    for(int i = 0; i < mRows; ++i)
-    for(int j = 0; j < mCols; ++j)
+    while(!mChordQueue.empty())
     {
-        ret = chord(i, j) || ret;
+        const int n = mChordQueue.back();
+        mChordQueue.pop_back();
+        mData[n].mQueued = false;
+        if(mJournal)
+            mJournal->p_note(n, MoveJournal::dequeued);
+        ret = (this->*mKernels->chord)(n) || ret;
     }
     return ret;
 }
 
+void Minesweeper::set_flag(int i, int j, bool flag)
+{
+    const int n = index(i, j);
+    if(mData[n].mFlag == flag)
+        return;
+    mData[n].mFlag = flag;
+    p_hash(n, flag_key);
+    p_touch(n);
+    if(mJournal)
+        mJournal->p_note(n, MoveJournal::flagged);
+    (this->*mKernels->queue_nbs)(n);
+}
+
+void Minesweeper::toggle_flag(int i, int j)
+{
+    set_flag(i, j, !cell(i, j).mFlag);
+}
+
 bool Minesweeper::click(int i, int j)
 {
     if(cell(i, j).mVisible)
@@ -173,20 +303,122 @@ bool Minesweeper::click(int i, int j)
         return uncover_if_unmarked(i, j);
 }
 
+template<class Move> auto Minesweeper::p_record(std::vector<Position>& delta, Move move) -> MoveResult
+{
+    MoveResult res;
+    res.before = mState;
+    const std::size_t old_size = delta.size();
+    mDelta = &delta;
+    //Stop recording even if the move throws, as delta may not outlive this call
+    struct Detach
+    {
+        Minesweeper& game;
+        ~Detach() { game.mDelta = nullptr; }
+    } detach{*this};
+    move();
+    res.uncovered = delta.size() - old_size;
+    res.after = mState;
+    return res;
+}
+
+auto Minesweeper::uncover(int i, int j, std::vector<Position>& delta) -> MoveResult
+{
+    return p_record(delta, [=]() { uncover(i, j); });
+}
+
+auto Minesweeper::chord(int i, int j, std::vector<Position>& delta) -> MoveResult
+{
+    return p_record(delta, [=]() { chord(i, j); });
+}
+
+auto Minesweeper::chord_all(std::vector<Position>& delta) -> MoveResult
+{
+    return p_record(delta, [=]() { chord_all(); });
+}
+
+auto Minesweeper::click(int i, int j, std::vector<Position>& delta) -> MoveResult
+{
+    return p_record(delta, [=]() { click(i, j); });
+}
+
 void Minesweeper::replay()
 {
-    for(CellEntry& c: mData)
-        c.flag = c.mVisible = false;
+    for(int n: mTouched)
+        mData[n].mFlag = mData[n].mVisible = mData[n].mQueued = mData[n].mTouched = false;
+    mTouched.clear();
+    mChordQueue.clear();
+    mHash = 0;
+    mCovered = cells() - mMines;
     mState = GameState::running;
 }
 
 void Minesweeper::reset()
 {
-    for(CellEntry& c: mData)
-        c = CellEntry();
+    if(mState == GameState::uninitialized)
+    {
+        //Mines may have been placed anywhere since, so all cells have to be visited
+        for(int i = 0; i < mRows; ++i)
+        for(int j = 0; j < mCols; ++j)
+            cell(i, j) = CellEntry();
+    }
+    else
+    {
+        for(int n: mTouched)
+            mData[n] = CellEntry();
+        for(int n: mMineCells)
+            mData[n] = CellEntry();
+    }
+    mTouched.clear();
+    mMineCells.clear();
+    mChordQueue.clear();
+    mRegion.clear();
+    mRegionStart.clear();
+    mRegionCells.clear();
+    mHash = 0;
     mState = GameState::uninitialized;
 }
 
+void Minesweeper::p_set_mine(int i, int j, bool mine)
+{
+    const int n = index(i, j);
+    //reset() only visits the listed mines of initialized games
+    if(mine && !mData[n].mMine && mState != GameState::uninitialized)
+    {
+        //Mines which have been taken away again are still listed, so the list may fill up
+        if(mMineCells.size() >= cells())
+        {
+            mMineCells.clear();
+            for(int k = 0; k < int(mData.size()); ++k)
+            {
+                if(mData[k].mMine)
+                    mMineCells.push_back(k);
+            }
+        }
+        mMineCells.push_back(n);
+    }
+    mData[n].mMine = mine;
+}
+
+void Minesweeper::p_set_visible(int i, int j, bool visible)
+{
+    const int n = index(i, j);
+    if(mData[n].mVisible == visible)
+        return;
+    mData[n].mVisible = visible;
+    p_touch(n);
+    //The numbers are only known once the game has been initialized, init() catches up on the rest
+    if(mState == GameState::uninitialized || mData[n].mMine)
+        return;
+    p_hash(n, mData[n].mAdjacents);
+    if(visible)
+    {
+        p_queue_chord(n);
+        --mCovered;
+    }
+    else
+        ++mCovered;
+}
+
 void Minesweeper::p_print(std::ostream& os) const
 {
     os << "   ";
@@ -203,7 +435,7 @@ void Minesweeper::p_print(std::ostream& os) const
             else if(cell(i, j).mAdjacents == 0)
                 os << '.';
             else
-                os << cell(i, j).mAdjacents;
+                os << int(cell(i, j).mAdjacents);
         }
         os << ' ' << std::setw(2) << i;
     }
@@ -225,7 +457,7 @@ std::ostream& operator<<(std::ostream& os, const Minesweeper& ms)
         {
             if(!ms.cell(i, j).visible())
             {
-                if(ms.cell(i, j).flag)
+                if(ms.cell(i, j).flag())
                     os << 'F';
                 else
                     os << '?';
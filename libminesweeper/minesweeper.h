@@ -21,11 +21,19 @@
 #ifndef MINESWEEPER_H_INCLUDED
 #define MINESWEEPER_H_INCLUDED
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
+class CompactMinesweeper;
+class MoveJournal;
+
 /** \brief Class for representing a Minesweeper game state
  * \note Methods beginning with \c p_ are "cheating functions". */
 class Minesweeper
@@ -35,8 +43,11 @@ public:
     class CellEntry
     {
     public:
-        ///Cell is flagged by the player, i.e. he supposes a mine there
-        bool flag;
+        ///Creates a covered and unflagged cell without mine
+        CellEntry();
+
+        ///Returns if the cell is flagged by the player, i.e. he supposes a mine there
+        bool flag() const { return mFlag; }
         ///Returns if the cell is uncovered
         bool visible() const { return mVisible; }
         ///Returns the number of mines in the adjacent cells if this cell is visible, or -1 otherwise
@@ -46,19 +57,34 @@ public:
         bool p_mine() const { return mMine; }
         ///Returns the number of mines in the adjacent cells
         int p_adjacents() const { return mAdjacents; }
-        ///Sets whether the cell contains a mine
+        /** \brief Sets whether the cell contains a mine
+         *
+         * Only for games which have not been \ref init'ed, as Minesweeper::reset() would not
+         * find the mine afterwards. Use Minesweeper::p_set_mine() for the others.
+         */
         void p_set_mine(bool mine) { mMine = mine; }
-        ///Sets whether the cell is uncovered
+        /** \brief Sets whether the cell is uncovered
+         * \deprecated Cells uncovered this way are not covered again by Minesweeper::replay()
+         * and Minesweeper::reset() of \ref init'ed games. Use Minesweeper::p_set_visible().
+         */
         void p_set_visible(bool visible) { mVisible = visible; }
 
     private:
+        bool mFlag;
         bool mMine;
         bool mVisible;
-        int mAdjacents;
+        ///Whether the cell is in Minesweeper::mChordQueue
+        bool mQueued;
+        ///Whether the cell is in Minesweeper::mTouched
+        bool mTouched;
+        signed char mAdjacents;
 
-        explicit CellEntry(bool mine = false, bool visible = false, int adjacents = -1, bool flag = false);
+        CellEntry(bool mine, bool visible, int adjacents, bool flag);
 
         friend class Minesweeper;
+        friend class CompactMinesweeper;
+        friend class MoveJournal;
+        friend class ConcurrentMinesweeper;
     };
 
     ///State of the game
@@ -74,7 +100,27 @@ public:
         loss
     };
 
-    /// \throw std::out_of_range if rows or cols is negative
+    ///Coordinates (row, column) of a cell
+    typedef std::pair<int, int> Position;
+
+    ///Outcome of a move made by one of the methods which report the uncovered cells
+    struct MoveResult
+    {
+        ///The number of cells uncovered by the move
+        std::size_t uncovered;
+        ///The state of the game before the move
+        GameState before;
+        ///The state of the game after the move
+        GameState after;
+
+        ///Returns if the move has changed the state of the game
+        bool state_changed() const { return before != after; }
+    };
+
+    /** \throw std::out_of_range if rows or cols is negative
+     * \throw std::length_error if the field including its border has more than INT_MAX cells.
+     * Use CompactMinesweeper for such fields.
+     */
     Minesweeper(int rows, int cols);
 
     /** \brief Initializes the minefield with randomly placed mines
@@ -82,12 +128,16 @@ public:
      * \param rng A boost::random generator
      * \param startr The row of the starting position
      * \param startc The column of the starting position
-     * \throw std::out_of_range if mines >= cells()
+     * \param safe_nbs Whether the neighbors of the starting position are left open as well
+     * \throw std::out_of_range if mines >= cells() or if there are not enough cells outside
+     * of the starting area
      *
      * The specified number of mines is randomly placed across the field,
      * but the cell (\c startr, \c startc) is left open.
+     * The mines are drawn using Floyd's sampling algorithm, so the work done
+     * is proportional to the number of mines, regardless of the density.
      */
-    template<class RNG> void rand_init(unsigned int mines, RNG& rng, int startr = -1, int startc = -1);
+    template<class RNG> void rand_init(unsigned int mines, RNG& rng, int startr = -1, int startc = -1, bool safe_nbs = false);
 
     /** \brief Initializes the game
      *
@@ -102,6 +152,19 @@ public:
     int cols() const { return mCols; }
     ///Returns the number of cells
     unsigned int cells() const { return mRows*mCols; }
+    ///Returns the number of mines. Only valid once the game has been \ref init'ed
+    unsigned int mines() const { return mMines; }
+    ///Returns the number of covered cells without a mine. Only valid once the game has been \ref init'ed
+    unsigned int covered() const { return mCovered; }
+    /** \brief Returns a Zobrist hash of what the player sees, i.e. the uncovered numbers and the flags
+     *
+     * Each uncovered number and each flag contributes a key depending on its cell, and the keys
+     * are combined by XOR, so the hash is updated in constant time by every change. Games of the
+     * same size which show the same numbers and flags have the same hash, regardless of the order
+     * of the moves and of the mines under the covered cells. A game without uncovered cells and
+     * flags has the hash 0. Cells uncovered with the deprecated CellEntry::p_set_visible() are not included.
+     */
+    std::uint64_t hash() const { return mHash; }
     ///Checks if (\c i, \c j) is in range of the field
     bool in_range(int i, int j) const;
 
@@ -147,23 +210,94 @@ public:
 
     /** \brief Chords around all fully flagged cells
      * \return \c true if at least one cell has been uncovered
+     *
+     * Only the cells which have been uncovered or had the flags around them changed
+     * since the last call are examined. Cells uncovered by chording are examined as well,
+     * until no more cells can be chorded.
      */
     bool chord_all();
 
+    ///Flags or unflags the cell (\c i, \c j)
+    void set_flag(int i, int j, bool flag);
+
+    ///Toggles the flag of the cell (\c i, \c j)
+    void toggle_flag(int i, int j);
+
     /** \brief Calls uncover_if_unmarked() if (\c i, \c j) is visible and chord() else
      * \return \c true if at least one cell has been uncovered
      */
     bool click(int i, int j);
 
-    ///Covers and unmarks all cells. The mines are left as they were.
+    /** \brief Makes a move at (\c i, \c j) like uncover() and reports the uncovered cells
+     * \param delta The positions of the newly uncovered cells are appended to it
+     *
+     * The vector can be reused between moves, so that no memory is allocated once it is large enough.
+     */
+    MoveResult uncover(int i, int j, std::vector<Position>& delta);
+
+    ///Like chord(), appending the positions of the newly uncovered cells to \c delta
+    MoveResult chord(int i, int j, std::vector<Position>& delta);
+
+    ///Like chord_all(), appending the positions of the newly uncovered cells to \c delta
+    MoveResult chord_all(std::vector<Position>& delta);
+
+    ///Like click(), appending the positions of the newly uncovered cells to \c delta
+    MoveResult click(int i, int j, std::vector<Position>& delta);
+
+    /** \brief Covers and unmarks all cells. The mines are left as they were.
+     *
+     * Only the cells uncovered or flagged since the last replay() or reset() are visited,
+     * so this is cheap after a short game on a large field.
+     */
     void replay();
 
-    ///Resets the game into the uninitialized state
+    /** \brief Resets the game into the uninitialized state
+     *
+     * Once the game has been \ref init'ed, only the mines found by init() and the cells
+     * uncovered or flagged since are visited. The numbers of adjacent mines of the other cells are left as they were
+     * until the next init().
+     */
     void reset();
 
     ///Prints out the field, including the covered cells
     void p_print(std::ostream& os) const;
 
+    /** \brief Sets whether the cell (\c i, \c j) contains a mine
+     *
+     * Unlike CellEntry::p_set_mine(), this may be used after init(), as the cell is remembered
+     * for reset(). The numbers and the mine count are only updated by calling init() again.
+     */
+    void p_set_mine(int i, int j, bool mine);
+
+    /** \brief Sets whether the cell (\c i, \c j) is uncovered
+     *
+     * Unlike CellEntry::p_set_visible(), the cell is covered again by replay() and reset(),
+     * and it counts towards hash() and covered(). The state of the game is left as it is,
+     * even if no covered cells remain. Cells uncovered before init() get their numbers from it.
+     */
+    void p_set_visible(int i, int j, bool visible);
+
+    /** \brief Randomly selects cells of a field, leaving out the starting area
+     * \param rows The number of rows of the field
+     * \param cols The number of columns of the field
+     * \param count The number of cells to select
+     * \param rng A boost::random generator
+     * \param startr The row of the starting position
+     * \param startc The column of the starting position
+     * \param safe_nbs Whether the neighbors of the starting position are left out as well
+     * \param take Called for the selected cells
+     * \throw std::out_of_range if count >= rows*cols or if there are not enough cells outside
+     * of the starting area
+     *
+     * This is the placement algorithm behind rand_init(), usable for other field representations.
+     * It uses Floyd's sampling algorithm and calls \c take at most 2*count times.
+     * take should have the following signature:
+     * \code bool take(int i, int j) \endcode
+     * and return \c false if the cell has already been taken before.
+     */
+    template<class RNG, class Func> static void sample_cells(int rows, int cols, std::uint64_t count, RNG& rng,
+                                                             int startr, int startc, bool safe_nbs, Func take);
+
     /** \brief Calls \c f for each neighbor of (\c i, \c j) in the field
      * \sa for_each_nb()
      */
@@ -177,48 +311,312 @@ public:
      */
     template<class Func> static void for_each_nb(int i, int j, Func f);
 
+protected:
+    /** \brief Arrays provided by a derived class which knows the size of the field in advance
+     *
+     * With n = (rows + 2) * (cols + 2), \c region_cells needs room for 4 n elements,
+     * \c region_start for n + 1 and the other arrays for n.
+     */
+    struct Buffers
+    {
+        CellEntry* cells;
+        int* region;
+        int* region_start;
+        int* region_cells;
+        int* open_stack;
+        int* chord_queue;
+        int* touched;
+        int* mine_cells;
+    };
+
+    ///The functions which visit the neighbors of cells, compiled for one row stride, see p_kernels()
+    struct Kernels
+    {
+        void (Minesweeper::*count_adjacents)();
+        void (Minesweeper::*build_regions)();
+        bool (Minesweeper::*chord)(int);
+        void (Minesweeper::*queue_nbs)(int);
+    };
+
+    /** \brief Creates a field which keeps its state in the arrays \c buffers
+     * \param rows The number of rows
+     * \param cols The number of columns
+     * \param buffers The arrays, which have to outlive the object
+     * \param kernels The neighbor functions to use, p_kernels<0>() or p_kernels<cols + 2>()
+     * \throw std::out_of_range if rows or cols is negative
+     * \throw std::length_error if the field is too large, see Minesweeper(int, int)
+     *
+     * Copies of the object allocate their own storage. Assigning a game to the object copies it into
+     * the arrays, which throws std::length_error if the field including its border has more cells.
+     */
+    Minesweeper(int rows, int cols, const Buffers& buffers, const Kernels& kernels);
+
+    /** \brief Returns the neighbor functions for rows of \c Stride cells including the border
+     *
+     * With the stride known at compile time the neighbor offsets are constants, and the loops over
+     * the neighbors are unrolled. Stride 0 stands for the runtime stride of the game.
+     */
+    template<int Stride> static const Kernels& p_kernels();
+
 private:
+    ///Restores the state of the game, which has no public setter
+    friend class Snapshot;
+    ///Records the changes of moves and rolls them back
+    friend class MoveJournal;
+    ///Reuses games with p_reshape()
+    friend class MinesweeperPool;
+
+    /** \brief Array which either owns its elements or uses ones provided by a derived class
+     *
+     * Owned arrays grow like std::vector. Provided arrays have a fixed capacity and throw
+     * std::length_error when it is exceeded. Copies of an array own their elements, and so do
+     * arrays moved from a provided one. Assigning to a provided array copies into it.
+     */
+    template<class T> class Storage
+    {
+    public:
+        ///Creates an empty owned array
+        Storage();
+        ///Uses the \c capacity elements at \c data, which have to outlive the array
+        Storage(T* data, std::size_t capacity);
+        Storage(const Storage& other);
+        Storage(Storage&& other);
+        Storage& operator=(const Storage& other);
+        Storage& operator=(Storage&& other);
+
+        T& operator[](std::size_t n) { return mData[n]; }
+        const T& operator[](std::size_t n) const { return mData[n]; }
+        T* begin() { return mData; }
+        T* end() { return mData + mSize; }
+        const T* begin() const { return mData; }
+        const T* end() const { return mData + mSize; }
+        T& back() { return mData[mSize-1]; }
+        const T& back() const { return mData[mSize-1]; }
+        std::size_t size() const { return mSize; }
+        bool empty() const { return mSize == 0; }
+        ///Returns the number of elements which fit into the array without allocating
+        std::size_t capacity() const { return mCapacity; }
+
+        void push_back(const T& value)
+        {
+            if(mSize == mCapacity)
+                p_reserve(mSize + 1);
+            mData[mSize++] = value;
+        }
+        void pop_back() { --mSize; }
+        void clear() { mSize = 0; }
+        ///Changes the size, keeping the storage if it is large enough. Elements which come into use keep their values.
+        void resize(std::size_t size);
+        ///Changes the size to \c size elements of the value \c value
+        void assign(std::size_t size, const T& value);
+
+    private:
+        std::vector<T> mOwned;
+        T* mData;
+        std::size_t mSize;
+        std::size_t mCapacity;
+        bool mProvided;
+
+        ///Makes room for at least \c size elements
+        void p_reserve(std::size_t size);
+    };
+
+    /** \brief The cells, surrounded by a ring of border cells
+     *
+     * The border cells are uncovered, unflagged and contain no mine,
+     * so neighbors can be visited without range checks.
+     * It comes first, so that assigning a game which does not fit into provided cells fails
+     * before anything has been changed.
+     */
+    Storage<CellEntry> mData;
     int mRows, mCols;
-    std::vector<CellEntry> mData;
+    ///Distance between two rows in mData. Each row has a border cell on both sides.
+    int mStride;
+    ///The neighbor functions used by the game
+    const Kernels* mKernels;
     GameState mState;
     ///The number of covered fields
     unsigned int mCovered;
+    ///The number of mines, as counted by init()
+    unsigned int mMines;
+
+    /** \brief Zero region index of each cell in mData
+     *
+     * For cells with 0 adjacent mines this is the index of the region they belong to.
+     * For other cells it is the last region which listed them as border while building
+     * the index, or -1.
+     */
+    Storage<int> mRegion;
+    ///Offsets of the regions' cells in mRegionCells, with one extra entry at the end
+    Storage<int> mRegionStart;
+    /** \brief The cells of each region, i.e. its zero cells and their numbered border, as indices into mData
+     *
+     * A numbered cell borders at most four regions, as any two of its neighbors which are not
+     * corners are adjacent to each other, so this has at most four entries per cell.
+     */
+    Storage<int> mRegionCells;
+    ///Stack of cells whose neighbors still have to be visited by p_build_regions()
+    Storage<int> mOpenStack;
+    /** \brief Uncovered numbered cells which might have become chordable since the last chord_all()
+     *
+     * Border cells are marked as queued all the time, so they never enter the queue.
+     * It is used as a stack: cells are only pushed to and popped from the back.
+     * MoveJournal relies on this to undo and redo the changes of the queue.
+     */
+    Storage<int> mChordQueue;
+    ///Receives the positions of uncovered cells during a move with delta reporting, or \c nullptr
+    std::vector<Position>* mDelta;
+    ///Receives the changed cells during a move made through a MoveJournal, or \c nullptr
+    MoveJournal* mJournal;
+    ///Cells uncovered or flagged since the last replay() or reset(), each listed once
+    Storage<int> mTouched;
+    ///The cells containing mines, as found by init() and added by p_set_mine()
+    Storage<int> mMineCells;
+    ///See hash()
+    std::uint64_t mHash;
+
+    ///Index of the flag key in p_zobrist(), after those of the numbers 0 to 8
+    static const int flag_key = 9;
+
+    ///Offsets of the neighbors in a row-major field with rows of \c stride cells, in the order of for_each_nb_in_range()
+    struct NbOffsets
+    {
+        int off[8];
+
+        explicit NbOffsets(int stride): off{-stride, -stride-1, -stride+1, stride, stride-1, stride+1, -1, 1} {}
+        const int* begin() const { return off; }
+        const int* end() const { return off + 8; }
+    };
+
+    ///Returns the index of the cell (\c i, \c j) in mData
+    int index(int i, int j) const { return (i+1)*mStride + j+1; }
+
+    ///Returns \c Stride, or the stride of the game if it is 0
+    template<int Stride> int p_stride() const { return Stride ? Stride : mStride; }
+
+    ///Returns the Zobrist key of the cell mData[\c n] showing the number \c what, or a flag if it is flag_key
+    static std::uint64_t p_zobrist(int n, int what);
+
+    ///Adds or removes the key p_zobrist(\c n, \c what) in mHash
+    void p_hash(int n, int what) { mHash ^= p_zobrist(n, what); }
+
+    ///Throws if the field can not be indexed with int, see Minesweeper(int, int)
+    static void p_check_size(int rows, int cols);
+
+    ///Returns the number of cells of a field of \c rows times \c cols cells including its border
+    static std::size_t p_padded(int rows, int cols) { return std::size_t(rows + 2)*std::size_t(cols + 2); }
 
-    ///Recursively uncovers all the cells' neigbors where the number of adjacents is 0.
-    void p_rec_uncover();
+    ///Sets up the border and the cells of mData
+    void p_init_cells();
 
-    /** \brief Uncovers the cell (\c i, \c j).
+    /** \brief Turns the game into a new uninitialized one of \c rows times \c cols cells
+     *
+     * The storage of the cells and of the other members is kept, so this does not allocate
+     * if the game has been at least that large before. Only for games owning their cells.
+     */
+    void p_reshape(int rows, int cols);
+
+    ///Computes the numbers of adjacent mines for init()
+    template<int Stride> void p_count_adjacents();
+
+    /** \brief Builds the zero region index.
+     *
+     * A region is a connected set of cells with 0 adjacent mines, together with
+     * the numbered cells bordering it, i.e. exactly the cells uncovered by
+     * an opening. The index depends only on the mines, so it survives replay().
+     */
+    template<int Stride> void p_build_regions();
+
+    ///Calls \c move and reports the cells it uncovers to \c delta
+    template<class Move> MoveResult p_record(std::vector<Position>& delta, Move move);
+
+    ///Makes a move at the cell mData[\c n], like uncover()
+    bool p_open(int n);
+
+    ///Chords around the cell mData[\c n], like chord()
+    template<int Stride> bool p_chord(int n);
+
+    ///Adds the neighbors of the cell mData[\c n] to mChordQueue after its flag has changed
+    template<int Stride> void p_queue_nbs(int n);
+
+    ///Adds the cell mData[\c n] to mChordQueue if it is uncovered, numbered and not yet queued
+    void p_queue_chord(int n);
+
+    ///Adds the cell mData[\c n] to mTouched if it is not listed yet
+    void p_touch(int n);
+
+    ///Uncovers all the cells of the zero region \c region
+    void p_uncover_region(int region);
+
+    /** \brief Uncovers the cell mData[\c n].
      * \return \c true if the cell was not covered before.
      */
-    bool p_uncover(int i, int j);
+    bool p_uncover(int n);
 };
 
 ///Prints out the field
 std::ostream& operator<<(std::ostream& os, const Minesweeper& ms);
 
-template<class RNG> void Minesweeper::rand_init(unsigned int mines, RNG& rng, int startr, int startc)
+template<class RNG> void Minesweeper::rand_init(unsigned int mines, RNG& rng, int startr, int startc, bool safe_nbs)
 {
-    if(mines >= cells())
-        throw std::out_of_range("The number of mines must be smaller than the number of cells");
     if(mState != GameState::uninitialized)
         throw std::runtime_error("The field has already been initialized");
 
-    std::uniform_int_distribution<int> rdist(0, mRows-1), cdist(0, mCols-1);
-    for(; mines > 0; --mines)
+    sample_cells(mRows, mCols, mines, rng, startr, startc, safe_nbs, [this](int i, int j)
     {
-        int i, j;
-        //Don't place any mines at the starting position, and don't place double mines
-        do
-        {
-            i = rdist(rng);
-            j = cdist(rng);
-        } while((i == startr && j == startc) || cell(i, j).mMine);
+        if(cell(i, j).mMine)
+            return false;
         cell(i, j).mMine = true;
-    }
+        return true;
+    });
 
     init();
 }
 
+template<class RNG, class Func> void Minesweeper::sample_cells(int rows, int cols, std::uint64_t count, RNG& rng,
+                                                              int startr, int startc, bool safe_nbs, Func take)
+{
+    const std::uint64_t cells = std::uint64_t(rows)*cols;
+    if(count >= cells)
+        throw std::out_of_range("The number of mines must be smaller than the number of cells");
+
+    //Collect the cells of the starting area in ascending order
+    std::uint64_t excluded[9];
+    unsigned int nexcl = 0;
+    if(0 <= startr && startr < rows && 0 <= startc && startc < cols)
+    {
+        for(int i = startr-1; i <= startr+1; ++i)
+        for(int j = startc-1; j <= startc+1; ++j)
+        {
+            if(0 <= i && i < rows && 0 <= j && j < cols && (safe_nbs || (i == startr && j == startc)))
+                excluded[nexcl++] = std::uint64_t(i)*cols + j;
+        }
+    }
+    const std::uint64_t eligible = cells - nexcl;
+    if(count > eligible)
+        throw std::out_of_range("The number of mines must be smaller than the number of cells outside the starting area");
+
+    //Maps an index in [0, eligible) to the corresponding cell outside the starting area and takes it
+    auto take_nth = [&](std::uint64_t n)
+    {
+        for(unsigned int k = 0; k < nexcl && excluded[k] <= n; ++k)
+            ++n;
+        return take(int(n / cols), int(n % cols));
+    };
+
+    //Floyd's algorithm: every step takes exactly one cell, no retries needed.
+    //Indices which fit into unsigned int are drawn as such, so that fields of that size
+    //get the same mines for the same seed as before.
+    for(std::uint64_t m = eligible - count; m < eligible; ++m)
+    {
+        const std::uint64_t n = m <= std::numeric_limits<unsigned int>::max()
+            ? std::uniform_int_distribution<unsigned int>(0, m)(rng)
+            : std::uniform_int_distribution<std::uint64_t>(0, m)(rng);
+        if(!take_nth(n))
+            take_nth(m);
+    }
+}
+
 template<class Func> void Minesweeper::for_each_nb_in_range(int i, int j, Func f) const
 {
     if(i > 0)
@@ -250,4 +648,189 @@ template<class Func> void Minesweeper::for_each_nb(int i, int j, Func f)
     f(i+1, j-1); f(i+1, j  ); f(i+1, j+1);
 }
 
+template<int Stride> auto Minesweeper::p_kernels() -> const Kernels&
+{
+    static const Kernels kernels = {
+        &Minesweeper::p_count_adjacents<Stride>,
+        &Minesweeper::p_build_regions<Stride>,
+        &Minesweeper::p_chord<Stride>,
+        &Minesweeper::p_queue_nbs<Stride>
+    };
+    return kernels;
+}
+
+template<int Stride> void Minesweeper::p_count_adjacents()
+{
+    const NbOffsets nbs(p_stride<Stride>());
+    mMineCells.clear();
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        const int n = index(i, j);
+        if(mData[n].mMine)
+        {
+            //reset() may have left a number from the last game
+            mData[n].mAdjacents = -1;
+            mMineCells.push_back(n);
+            continue;
+        }
+        //Compute the number of mines in the neighbor fields
+        int adj = 0;
+        for(int off: nbs)
+            adj += mData[n + off].mMine;
+        mData[n].mAdjacents = adj;
+    }
+}
+
+template<int Stride> void Minesweeper::p_build_regions()
+{
+    const NbOffsets nbs(p_stride<Stride>());
+    mRegion.assign(mData.size(), -1);
+    mRegionStart.clear();
+    mRegionCells.clear();
+    for(int i = 0; i < mRows; ++i)
+    for(int j = 0; j < mCols; ++j)
+    {
+        const int start = index(i, j);
+        if(mData[start].mMine || mData[start].mAdjacents != 0 || mRegion[start] != -1)
+            continue;
+        //Label a new region by flooding from (i, j)
+        const int region = mRegionStart.size();
+        mRegionStart.push_back(mRegionCells.size());
+        mRegion[start] = region;
+        mRegionCells.push_back(start);
+        mOpenStack.clear();
+        mOpenStack.push_back(start);
+        while(!mOpenStack.empty())
+        {
+            const int n = mOpenStack.back();
+            mOpenStack.pop_back();
+            for(int off: nbs)
+            {
+                //Border cells have no adjacents, and mines never border zero cells
+                const int m = n + off;
+                if(mRegion[m] == region || mData[m].mAdjacents < 0)
+                    continue;
+                mRegion[m] = region;
+                mRegionCells.push_back(m);
+                if(mData[m].mAdjacents == 0)
+                    mOpenStack.push_back(m);
+            }
+        }
+    }
+    mRegionStart.push_back(mRegionCells.size());
+}
+
+template<int Stride> bool Minesweeper::p_chord(int n)
+{
+    if(!mData[n].mVisible)
+        return false;
+    const NbOffsets nbs(p_stride<Stride>());
+    //Compute the number of adjacent flagged cells
+    int markeds = 0;
+    for(int off: nbs)
+        markeds += mData[n + off].mFlag;
+    if(markeds != mData[n].mAdjacents)
+        return false;
+    //True is returned if at least one cell has been uncovered.
+    //The border cells are uncovered, so p_open() leaves them alone.
+    bool ret = false;
+    for(int off: nbs)
+    {
+        if(!mData[n + off].mFlag)
+            ret = p_open(n + off) || ret;
+    }
+    return ret;
+}
+
+template<int Stride> void Minesweeper::p_queue_nbs(int n)
+{
+    for(int off: NbOffsets(p_stride<Stride>()))
+        p_queue_chord(n + off);
+}
+
+template<class T> Minesweeper::Storage<T>::Storage():
+    mData(nullptr),
+    mSize(0),
+    mCapacity(0),
+    mProvided(false)
+{}
+
+template<class T> Minesweeper::Storage<T>::Storage(T* data, std::size_t capacity):
+    mData(data),
+    mSize(0),
+    mCapacity(capacity),
+    mProvided(true)
+{}
+
+template<class T> Minesweeper::Storage<T>::Storage(const Storage& other):
+    mOwned(other.begin(), other.end()),
+    mData(mOwned.data()),
+    mSize(other.mSize),
+    mCapacity(other.mSize),
+    mProvided(false)
+{}
+
+template<class T> Minesweeper::Storage<T>::Storage(Storage&& other):
+    Storage()
+{
+    *this = std::move(other);
+}
+
+template<class T> auto Minesweeper::Storage<T>::operator=(const Storage& other) -> Storage&
+{
+    if(this == &other)
+        return *this;
+    if(other.mSize > mCapacity)
+    {
+        if(mProvided)
+            throw std::length_error("The game does not fit into the provided storage");
+        mOwned.assign(other.begin(), other.end());
+        mData = mOwned.data();
+        mCapacity = mOwned.size();
+    }
+    else
+        std::copy(other.begin(), other.end(), mData);
+    mSize = other.mSize;
+    return *this;
+}
+
+template<class T> auto Minesweeper::Storage<T>::operator=(Storage&& other) -> Storage&
+{
+    //Provided elements stay where they are, so they can only be copied
+    if(mProvided || other.mProvided)
+        return *this = other;
+    mOwned = std::move(other.mOwned);
+    mData = other.mData;
+    mSize = other.mSize;
+    mCapacity = other.mCapacity;
+    other.mData = nullptr;
+    other.mSize = other.mCapacity = 0;
+    return *this;
+}
+
+template<class T> void Minesweeper::Storage<T>::resize(std::size_t size)
+{
+    if(size > mCapacity)
+        p_reserve(size);
+    mSize = size;
+}
+
+template<class T> void Minesweeper::Storage<T>::assign(std::size_t size, const T& value)
+{
+    resize(size);
+    std::fill(begin(), end(), value);
+}
+
+template<class T> void Minesweeper::Storage<T>::p_reserve(std::size_t size)
+{
+    if(mProvided)
+        throw std::length_error("The game does not fit into the provided storage");
+    std::vector<T> grown(std::max(size, 2*mCapacity));
+    std::copy(begin(), end(), grown.begin());
+    mOwned.swap(grown);
+    mData = mOwned.data();
+    mCapacity = mOwned.size();
+}
+
 #endif
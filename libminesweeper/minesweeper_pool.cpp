@@ -0,0 +1,131 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "minesweeper_pool.h"
+
+#include <algorithm>
+
+void MinesweeperPool::Deleter::operator()(Minesweeper* ms) const
+{
+    if(mPool)
+        mPool->p_release(ms);
+    else
+        delete ms;
+}
+
+MinesweeperPool::MinesweeperPool(std::size_t max_pooled):
+    mMaxPooled(max_pooled)
+{
+    //Releasing a game does not allocate either
+    mFree.reserve(max_pooled);
+}
+
+MinesweeperPool::~MinesweeperPool()
+{
+    for(const Entry& e: mFree)
+        delete e.game;
+}
+
+auto MinesweeperPool::acquire(int rows, int cols) -> Handle
+{
+    Minesweeper::p_check_size(rows, cols);
+    const std::size_t needed = std::size_t(rows+2)*(cols+2);
+    std::unique_lock<std::mutex> lock(mLock);
+    Minesweeper* ms = nullptr;
+    bool grown = false;
+    if(!mFree.empty())
+    {
+        //The smallest game which is large enough, or else the largest one
+        auto it = std::lower_bound(mFree.begin(), mFree.end(), needed,
+                                   [](const Entry& e, std::size_t n) { return e.capacity < n; });
+        if(it == mFree.end())
+        {
+            --it;
+            grown = true;
+        }
+        ms = it->game;
+        mFree.erase(it);
+        --mStats.pooled;
+    }
+    lock.unlock();
+
+    //The game is only counted once it exists, so failed calls do not show up in the statistics
+    const bool created = !ms;
+    try
+    {
+        if(created)
+            ms = new Minesweeper(rows, cols);
+        else
+            ms->p_reshape(rows, cols);
+    }
+    catch(...)
+    {
+        if(!created)
+        {
+            delete ms;
+            lock.lock();
+            ++mStats.dropped;
+        }
+        throw;
+    }
+
+    lock.lock();
+    ++mStats.acquired;
+    ++mStats.in_use;
+    if(created)
+        ++mStats.created;
+    else if(grown)
+        ++mStats.grown;
+    else
+        ++mStats.reused;
+    lock.unlock();
+    return Handle(ms, Deleter(this));
+}
+
+void MinesweeperPool::reserve(std::size_t count, int rows, int cols)
+{
+    std::vector<Handle> games;
+    for(std::size_t k = 0; k < count; ++k)
+        games.push_back(acquire(rows, cols));
+}
+
+auto MinesweeperPool::stats() const -> Stats
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mStats;
+}
+
+void MinesweeperPool::p_release(Minesweeper* ms)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+    --mStats.in_use;
+    if(mFree.size() >= mMaxPooled)
+    {
+        ++mStats.dropped;
+        lock.unlock();
+        delete ms;
+        return;
+    }
+    const Entry e = { ms, ms->mData.capacity() };
+    mFree.insert(std::upper_bound(mFree.begin(), mFree.end(), e,
+                                  [](const Entry& a, const Entry& b) { return a.capacity < b.capacity; }), e);
+    ++mStats.pooled;
+}
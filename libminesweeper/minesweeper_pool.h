@@ -0,0 +1,111 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MINESWEEPER_POOL_H_INCLUDED
+#define MINESWEEPER_POOL_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/** \brief Recycles Minesweeper objects and their cell storage between games
+ *
+ * acquire() hands out a game of the requested size. Released games are kept and turned
+ * into the next requested game, taking the smallest one whose storage is large enough.
+ * Their cell storage and the other buffers of the game keep their capacity, so once the
+ * pool has warmed up, starting a game does not allocate memory.
+ * The pool is thread-safe and has to outlive the games it has handed out.
+ */
+class MinesweeperPool
+{
+public:
+    ///Counters of the pool
+    struct Stats
+    {
+        ///Games handed out
+        std::size_t acquired = 0;
+        ///Games made from a released one whose storage was large enough
+        std::size_t reused = 0;
+        ///Games made from a released one whose storage had to grow
+        std::size_t grown = 0;
+        ///Games which had to be created
+        std::size_t created = 0;
+        ///Released games which have been destroyed because the pool was full or their storage could not grow
+        std::size_t dropped = 0;
+        ///Games handed out and not released yet
+        std::size_t in_use = 0;
+        ///Released games kept for reuse
+        std::size_t pooled = 0;
+    };
+
+    ///Returns a game to the pool it came from
+    class Deleter
+    {
+    public:
+        explicit Deleter(MinesweeperPool* pool = nullptr): mPool(pool) {}
+        void operator()(Minesweeper* ms) const;
+
+    private:
+        MinesweeperPool* mPool;
+    };
+
+    ///A game of the pool, which returns it to the pool when destroyed
+    typedef std::unique_ptr<Minesweeper, Deleter> Handle;
+
+    ///Creates a pool keeping at most \c max_pooled released games
+    explicit MinesweeperPool(std::size_t max_pooled = 64);
+    ~MinesweeperPool();
+
+    MinesweeperPool(const MinesweeperPool&) = delete;
+    MinesweeperPool& operator=(const MinesweeperPool&) = delete;
+
+    /** \brief Returns a new uninitialized game
+     * \throw std::out_of_range if rows or cols is negative
+     */
+    Handle acquire(int rows, int cols);
+
+    ///Creates \c count released games of \c rows times \c cols cells, so that acquiring them does not allocate
+    void reserve(std::size_t count, int rows, int cols);
+
+    ///Returns the counters of the pool
+    Stats stats() const;
+
+private:
+    ///A released game and the number of cells its storage can hold
+    struct Entry
+    {
+        Minesweeper* game;
+        std::size_t capacity;
+    };
+
+    mutable std::mutex mLock;
+    std::size_t mMaxPooled;
+    ///The released games, ordered by capacity
+    std::vector<Entry> mFree;
+    Stats mStats;
+
+    void p_release(Minesweeper* ms);
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "move_journal.h"
+
+#include <cassert>
+
+MoveJournal::MoveJournal(Minesweeper& ms):
+    mGame(ms),
+    mCurrent(0)
+{}
+
+template<class Func> bool MoveJournal::p_record(Func move)
+{
+    //Forget the undone moves
+    mMoves.resize(mCurrent);
+    mChanges.resize(mMoves.empty() ? 0 : mMoves.back().end);
+
+    Move m;
+    m.before = mGame.mState;
+    m.covered_before = mGame.mCovered;
+    mGame.mJournal = this;
+    struct Detach
+    {
+        Minesweeper& game;
+        ~Detach() { game.mJournal = nullptr; }
+    } detach{mGame};
+    const bool ret = move();
+    m.end = mChanges.size();
+    m.after = mGame.mState;
+    m.covered_after = mGame.mCovered;
+    mMoves.push_back(m);
+    ++mCurrent;
+    return ret;
+}
+
+bool MoveJournal::uncover(int i, int j)
+{
+    return p_record([=]() { return mGame.uncover(i, j); });
+}
+
+bool MoveJournal::uncover_if_unmarked(int i, int j)
+{
+    return p_record([=]() { return mGame.uncover_if_unmarked(i, j); });
+}
+
+bool MoveJournal::chord(int i, int j)
+{
+    return p_record([=]() { return mGame.chord(i, j); });
+}
+
+bool MoveJournal::chord_all()
+{
+    return p_record([=]() { return mGame.chord_all(); });
+}
+
+bool MoveJournal::click(int i, int j)
+{
+    return p_record([=]() { return mGame.click(i, j); });
+}
+
+void MoveJournal::set_flag(int i, int j, bool flag)
+{
+    p_record([=]() { mGame.set_flag(i, j, flag); return false; });
+}
+
+void MoveJournal::toggle_flag(int i, int j)
+{
+    p_record([=]() { mGame.toggle_flag(i, j); return false; });
+}
+
+bool MoveJournal::undo()
+{
+    if(!can_undo())
+        return false;
+    const Move& m = mMoves[--mCurrent];
+    const std::size_t begin = mCurrent > 0 ? mMoves[mCurrent-1].end : 0;
+    //The changes are taken back in reverse. Minesweeper uses its chord queue as a stack,
+    //so the entries pushed by the move are at its end and popped ones go back there.
+    for(std::size_t k = m.end; k-- > begin; )
+    {
+        const int n = int(mChanges[k] / 4);
+        Minesweeper::CellEntry& c = mGame.mData[n];
+        switch(Change(mChanges[k] % 4))
+        {
+        case uncovered:
+            c.mVisible = false;
+            mGame.p_hash(n, c.mAdjacents);
+            break;
+        case flagged:
+            c.mFlag = !c.mFlag;
+            mGame.p_hash(n, Minesweeper::flag_key);
+            break;
+        case queued:
+            assert(mGame.mChordQueue.back() == n);
+            mGame.mChordQueue.pop_back();
+            c.mQueued = false;
+            break;
+        case dequeued:
+            mGame.mChordQueue.push_back(n);
+            c.mQueued = true;
+            break;
+        }
+    }
+    mGame.mState = m.before;
+    mGame.mCovered = m.covered_before;
+    return true;
+}
+
+bool MoveJournal::redo()
+{
+    if(!can_redo())
+        return false;
+    const Move& m = mMoves[mCurrent];
+    const std::size_t begin = mCurrent > 0 ? mMoves[mCurrent-1].end : 0;
+    for(std::size_t k = begin; k < m.end; ++k)
+    {
+        const int n = int(mChanges[k] / 4);
+        Minesweeper::CellEntry& c = mGame.mData[n];
+        switch(Change(mChanges[k] % 4))
+        {
+        case uncovered:
+            c.mVisible = true;
+            mGame.p_hash(n, c.mAdjacents);
+            mGame.p_touch(n);
+            break;
+        case flagged:
+            c.mFlag = !c.mFlag;
+            mGame.p_hash(n, Minesweeper::flag_key);
+            mGame.p_touch(n);
+            break;
+        case queued:
+            mGame.mChordQueue.push_back(n);
+            c.mQueued = true;
+            break;
+        case dequeued:
+            assert(mGame.mChordQueue.back() == n);
+            mGame.mChordQueue.pop_back();
+            c.mQueued = false;
+            break;
+        }
+    }
+    mGame.mState = m.after;
+    mGame.mCovered = m.covered_after;
+    ++mCurrent;
+    return true;
+}
+
+void MoveJournal::clear()
+{
+    mChanges.clear();
+    mMoves.clear();
+    mCurrent = 0;
+}
@@ -0,0 +1,120 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MOVE_JOURNAL_H_INCLUDED
+#define MOVE_JOURNAL_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** \brief Records the moves made on a game, so that they can be undone and redone
+ *
+ * The moves are made through the journal, which records the cells uncovered or
+ * (un)flagged by each move, the changes to the queue of Minesweeper::chord_all() and
+ * the state of the game before and after it. So the game is restored exactly.
+ * Undoing or redoing a move only visits the cells it has changed, so rolling back
+ * is much cheaper than copying the game, which makes it suitable for speculative search.
+ *
+ * Making a new move discards the moves which have been undone.
+ * \warning While the journal is in use, all moves on the game have to be made through it.
+ * After Minesweeper::replay(), Minesweeper::reset() or Minesweeper::init() it has to be cleared.
+ */
+class MoveJournal
+{
+public:
+    ///Creates a journal for the game \c ms, which has to outlive it
+    explicit MoveJournal(Minesweeper& ms);
+
+    ///\copydoc Minesweeper::uncover()
+    bool uncover(int i, int j);
+    ///\copydoc Minesweeper::uncover_if_unmarked()
+    bool uncover_if_unmarked(int i, int j);
+    ///\copydoc Minesweeper::chord()
+    bool chord(int i, int j);
+    ///\copydoc Minesweeper::chord_all()
+    bool chord_all();
+    ///\copydoc Minesweeper::click()
+    bool click(int i, int j);
+    ///\copydoc Minesweeper::set_flag()
+    void set_flag(int i, int j, bool flag);
+    ///\copydoc Minesweeper::toggle_flag()
+    void toggle_flag(int i, int j);
+
+    /** \brief Takes back the last move which has not been undone
+     * \return \c false if there is no such move
+     */
+    bool undo();
+
+    /** \brief Makes the last undone move again
+     * \return \c false if there is no such move
+     */
+    bool redo();
+
+    ///Returns if there is a move to undo
+    bool can_undo() const { return mCurrent > 0; }
+    ///Returns if there is a move to redo
+    bool can_redo() const { return mCurrent < mMoves.size(); }
+    ///Returns the number of moves which can be undone
+    std::size_t moves() const { return mCurrent; }
+
+    ///Forgets all moves
+    void clear();
+
+private:
+    ///Kinds of changes, stored in the lowest two bits of the entries of mChanges
+    enum Change
+    {
+        uncovered,
+        flagged,
+        ///Pushed onto the back of Minesweeper::mChordQueue
+        queued,
+        ///Popped from the back of Minesweeper::mChordQueue
+        dequeued
+    };
+
+    struct Move
+    {
+        ///End of the move's changes in mChanges
+        std::size_t end;
+        Minesweeper::GameState before, after;
+        unsigned int covered_before, covered_after;
+    };
+
+    Minesweeper& mGame;
+    ///The changed cells of all moves, as index into Minesweeper::mData times 4 plus the Change
+    std::vector<std::uint64_t> mChanges;
+    std::vector<Move> mMoves;
+    ///Number of moves which have not been undone
+    std::size_t mCurrent;
+
+    ///Makes the move \c move on the game and records it
+    template<class Func> bool p_record(Func move);
+
+    ///Called by the game for each change during a move
+    void p_note(int n, Change what) { mChanges.push_back(4*std::uint64_t(n) + what); }
+
+    friend class Minesweeper;
+};
+
+#endif
@@ -0,0 +1,671 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "probability.h"
+#include "seeded_layout.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <map>
+
+namespace
+{
+
+///Returns the range [first, last) of the nonzero entries of \c a
+std::pair<std::size_t, std::size_t> support(const std::vector<double>& a)
+{
+    std::size_t first = 0, last = a.size();
+    while(first < last && a[first] == 0.0)
+        ++first;
+    while(last > first && a[last-1] == 0.0)
+        --last;
+    return std::make_pair(first, last);
+}
+
+///Convolution of two distributions over the number of mines
+std::vector<double> convolve(const std::vector<double>& a, const std::vector<double>& b)
+{
+    //The tails of large distributions underflow to 0, skipping them saves most of the work
+    const std::pair<std::size_t, std::size_t> sa = support(a), sb = support(b);
+    std::vector<double> res(a.size() + b.size() - 1, 0.0);
+    for(std::size_t x = sa.first; x < sa.second; ++x)
+    for(std::size_t y = sb.first; y < sb.second; ++y)
+        res[x + y] += a[x] * b[y];
+    return res;
+}
+
+///Returns res(j) = sum over x of a(x)*b(j + x), for j in [0, size)
+std::vector<double> correlate(const std::vector<double>& a, const std::vector<double>& b, std::size_t size)
+{
+    const std::pair<std::size_t, std::size_t> sa = support(a), sb = support(b);
+    std::vector<double> res(size, 0.0);
+    for(std::size_t j = 0; j < size; ++j)
+    for(std::size_t x = std::max(sa.first, sb.first - std::min(sb.first, j)); x < sa.second && j + x < sb.second; ++x)
+        res[j] += a[x] * b[j + x];
+    return res;
+}
+
+///Distribution of the number of mines in the components [l, r)
+std::vector<double> product(const std::vector<const std::vector<double>*>& dists, std::size_t l, std::size_t r)
+{
+    if(r == l)
+        return std::vector<double>(1, 1.0);
+    if(r - l == 1)
+        return *dists[l];
+    const std::size_t mid = (l + r) / 2;
+    return convolve(product(dists, l, mid), product(dists, mid, r));
+}
+
+/** \brief Computes the weight of each number of mines in each of the components [l, r)
+ *
+ * \c outside is the weight of each number of mines in [l, r) together, already summed over
+ * the solutions of the other components. The result for component c is stored in out[c].
+ * Splitting the range in halves keeps this at O(n^2) for n frontier cells, however many
+ * components there are.
+ */
+void weigh(const std::vector<const std::vector<double>*>& dists, std::size_t l, std::size_t r,
+           const std::vector<double>& outside, std::vector<std::vector<double>>& out)
+{
+    if(r - l == 1)
+    {
+        out[l] = outside;
+        return;
+    }
+    const std::size_t mid = (l + r) / 2;
+    const std::vector<double> left = product(dists, l, mid), right = product(dists, mid, r);
+    weigh(dists, l, mid, correlate(right, outside, left.size()), out);
+    weigh(dists, mid, r, correlate(left, outside, right.size()), out);
+}
+
+///Calls f(t) for every t in [0, count), on the pool if there is one
+template<class Func> void run_tasks(ThreadPool* pool, std::size_t count, Func f)
+{
+    if(pool)
+        pool->run(count, f);
+    else
+    {
+        for(std::size_t t = 0; t < count; ++t)
+            f(t);
+    }
+}
+
+///Natural logarithm of the binomial coefficient (n choose k)
+double log_choose(int n, int k)
+{
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+/** \brief Counts the mine assignments of a component
+ *
+ * The cells are assigned one after another. Assignments which lead to the same
+ * partial sums of the numbers that are not complete yet behave the same from there on,
+ * so the search is memoized on these sums: a forward pass counts the ways to reach
+ * each state, a backward pass the ways to complete it, and their products give the
+ * number of solutions where a given cell is a mine.
+ *
+ * The states of each step are processed in chunks of a fixed size, which can run in
+ * parallel. The chunk results are added up in chunk order, so the result does not
+ * depend on the number of threads.
+ */
+class Enumerator
+{
+public:
+    explicit Enumerator(const std::vector<int>& key);
+
+    ///Counts the solutions into \c solutions and \c mines, using \c pool if it is not null
+    void run(ThreadPool* pool);
+
+    ///Number of cells
+    const int n;
+    ///Number of solutions with k mines
+    std::vector<double> solutions;
+    ///Number of solutions with k mines where cell c is a mine, at index k*n + c
+    std::vector<double> mines;
+
+private:
+    ///Counts indexed by the number of mines
+    typedef std::vector<double> Counts;
+    ///Partial sums of the numbers which are not complete yet, to counts
+    typedef std::map<std::vector<int>, Counts> Layer;
+
+    ///Number of states processed by one task
+    static const std::size_t chunk_size = 64;
+    ///Counts are scaled down by a power of two when they reach 2^scale_limit
+    static const int scale_limit = 256;
+
+    std::vector<int> values;
+    ///Numbers of each cell
+    std::vector<std::vector<int>> of_cell;
+    ///Order in which cells are assigned. Neighboring cells come after each other,
+    ///so that numbers are completed early and the states stay few.
+    std::vector<int> order;
+    ///For step d, the numbers of the cell order[d] and how many of their cells come after it
+    std::vector<std::vector<int>> remaining;
+    ///For step d, the numbers with cells assigned before d and cells assigned from d on, ascending
+    std::vector<std::vector<int>> active;
+
+    /** \brief Assigns \c v to the cell of step \c d in state \c s
+     * \return \c false if that contradicts a number, otherwise the new state is stored in \c next
+     */
+    bool p_step(int d, const std::vector<int>& s, int v, std::vector<int>& next) const;
+
+    ///Returns the partial sum of number \c num in the state \c s of step \c d
+    int p_sum(int d, const std::vector<int>& s, int num) const;
+
+    ///Adds the states reached from \c states in step \c d to \c to
+    void p_forward(int d, const Layer::value_type* const* states, std::size_t count, Layer& to) const;
+
+    /** \brief Computes the completions of \c states in step \c d into \c from
+     *
+     * The solutions where the cell of step \c d is a mine are added to \c marginal.
+     */
+    void p_backward(int d, const Layer::value_type* const* states, std::size_t count,
+                    const Layer& rest, Counts* const* from, Counts& marginal) const;
+
+    /** \brief Keeps the counts of a layer from overflowing on huge components
+     * \return The power of two by which the counts have been divided
+     */
+    static int p_rescale(Layer& layer);
+};
+
+const std::size_t Enumerator::chunk_size;
+
+Enumerator::Enumerator(const std::vector<int>& key):
+    n(key[0]),
+    solutions(n + 1, 0.0),
+    mines((n + 1) * n, 0.0),
+    of_cell(n)
+{
+    std::vector<std::vector<int>> of_number;
+    for(std::size_t p = 1; p < key.size(); p += 2 + key[p+1])
+    {
+        for(int q = 0; q < key[p+1]; ++q)
+            of_cell[key[p+2+q]].push_back(values.size());
+        of_number.push_back(std::vector<int>(key.begin() + p + 2, key.begin() + p + 2 + key[p+1]));
+        values.push_back(key[p]);
+    }
+
+    //Breadth first search through the numbers
+    std::vector<char> seen(n, false);
+    for(int start = 0; start < n; ++start)
+    {
+        if(seen[start])
+            continue;
+        seen[start] = true;
+        order.push_back(start);
+        for(std::size_t head = order.size() - 1; head < order.size(); ++head)
+        {
+            for(int num: of_cell[order[head]])
+            for(int c: of_number[num])
+            {
+                if(!seen[c])
+                {
+                    seen[c] = true;
+                    order.push_back(c);
+                }
+            }
+        }
+    }
+
+    //Steps at which the numbers get their first and last cell
+    std::vector<int> first(values.size(), n), last(values.size(), -1), left(values.size());
+    for(std::size_t num = 0; num < values.size(); ++num)
+        left[num] = of_number[num].size();
+    remaining.resize(n);
+    for(int d = 0; d < n; ++d)
+    {
+        for(int num: of_cell[order[d]])
+        {
+            first[num] = std::min(first[num], d);
+            last[num] = d;
+            remaining[d].push_back(--left[num]);
+        }
+    }
+    active.resize(n + 1);
+    for(int d = 0; d <= n; ++d)
+    for(std::size_t num = 0; num < values.size(); ++num)
+    {
+        if(first[num] < d && last[num] >= d)
+            active[d].push_back(num);
+    }
+}
+
+int Enumerator::p_sum(int d, const std::vector<int>& s, int num) const
+{
+    auto it = std::lower_bound(active[d].begin(), active[d].end(), num);
+    return it != active[d].end() && *it == num ? s[it - active[d].begin()] : 0;
+}
+
+bool Enumerator::p_step(int d, const std::vector<int>& s, int v, std::vector<int>& next) const
+{
+    const std::vector<int>& nums = of_cell[order[d]];
+    for(std::size_t x = 0; x < nums.size(); ++x)
+    {
+        const int sum = p_sum(d, s, nums[x]) + v;
+        if(sum > values[nums[x]] || sum + remaining[d][x] < values[nums[x]])
+            return false;
+    }
+    next.clear();
+    for(int num: active[d+1])
+    {
+        const bool own = std::find(nums.begin(), nums.end(), num) != nums.end();
+        next.push_back(p_sum(d, s, num) + (own ? v : 0));
+    }
+    return true;
+}
+
+void Enumerator::p_forward(int d, const Layer::value_type* const* states, std::size_t count, Layer& to) const
+{
+    std::vector<int> next;
+    for(std::size_t x = 0; x < count; ++x)
+    for(int v = 0; v <= 1; ++v)
+    {
+        const Layer::value_type& st = *states[x];
+        if(!p_step(d, st.first, v, next))
+            continue;
+        Counts& c = to[next];
+        c.resize(std::max(c.size(), st.second.size() + v), 0.0);
+        for(std::size_t k = 0; k < st.second.size(); ++k)
+            c[k + v] += st.second[k];
+    }
+}
+
+void Enumerator::p_backward(int d, const Layer::value_type* const* states, std::size_t count,
+                            const Layer& rest, Counts* const* from, Counts& marginal) const
+{
+    std::vector<int> next;
+    for(std::size_t x = 0; x < count; ++x)
+    for(int v = 0; v <= 1; ++v)
+    {
+        const Layer::value_type& st = *states[x];
+        if(!p_step(d, st.first, v, next))
+            continue;
+        const Counts& r = rest.find(next)->second;
+        Counts& f = *from[x];
+        f.resize(std::max(f.size(), r.size() + v), 0.0);
+        for(std::size_t k = 0; k < r.size(); ++k)
+            f[k + v] += r[k];
+        if(v == 0)
+            continue;
+        for(std::size_t k1 = 0; k1 < st.second.size(); ++k1)
+        for(std::size_t k2 = 0; k2 < r.size(); ++k2)
+            marginal[k1 + 1 + k2] += st.second[k1] * r[k2];
+    }
+}
+
+int Enumerator::p_rescale(Layer& layer)
+{
+    double max = 0.0;
+    for(const Layer::value_type& st: layer)
+    for(double x: st.second)
+        max = std::max(max, x);
+    int exp = 0;
+    std::frexp(max, &exp);
+    if(exp < scale_limit)
+        return 0;
+    //Powers of two keep the counts exact
+    for(Layer::value_type& st: layer)
+    for(double& x: st.second)
+        x = std::ldexp(x, -exp);
+    return exp;
+}
+
+void Enumerator::run(ThreadPool* pool)
+{
+    std::vector<Layer> forward(n + 1), backward(n + 1);
+    std::vector<const Layer::value_type*> states;
+    //The counts of each layer have been divided by 2^scale
+    std::vector<int> forward_scale(n + 1, 0);
+    int backward_scale = 0;
+
+    //Ways to reach each state from the start
+    forward[0][std::vector<int>()] = Counts(1, 1.0);
+    for(int d = 0; d < n; ++d)
+    {
+        states.clear();
+        for(const Layer::value_type& st: forward[d])
+            states.push_back(&st);
+        const std::size_t chunks = (states.size() + chunk_size - 1) / chunk_size;
+        forward_scale[d+1] = forward_scale[d];
+        if(chunks == 1)
+        {
+            p_forward(d, states.data(), states.size(), forward[d+1]);
+            forward_scale[d+1] += p_rescale(forward[d+1]);
+            continue;
+        }
+        std::vector<Layer> parts(chunks);
+        run_tasks(pool, chunks, [&](std::size_t t)
+        {
+            p_forward(d, states.data() + t*chunk_size, std::min(chunk_size, states.size() - t*chunk_size), parts[t]);
+        });
+        for(const Layer& part: parts)
+        for(const Layer::value_type& st: part)
+        {
+            Counts& c = forward[d+1][st.first];
+            c.resize(std::max(c.size(), st.second.size()), 0.0);
+            for(std::size_t k = 0; k < st.second.size(); ++k)
+                c[k] += st.second[k];
+        }
+        forward_scale[d+1] += p_rescale(forward[d+1]);
+    }
+
+    //Ways to complete each state, and the solutions through each cell being a mine
+    backward[n][std::vector<int>()] = Counts(1, 1.0);
+    std::vector<Counts*> from;
+    for(int d = n; d-- > 0;)
+    {
+        states.clear();
+        from.clear();
+        for(const Layer::value_type& st: forward[d])
+        {
+            states.push_back(&st);
+            from.push_back(&backward[d][st.first]);
+        }
+        const std::size_t chunks = (states.size() + chunk_size - 1) / chunk_size;
+        std::vector<Counts> marginals(chunks, Counts(n + 1, 0.0));
+        run_tasks(pool, chunks, [&](std::size_t t)
+        {
+            p_backward(d, states.data() + t*chunk_size, std::min(chunk_size, states.size() - t*chunk_size),
+                       backward[d+1], from.data() + t*chunk_size, marginals[t]);
+        });
+        //Bring the solutions through this cell to the scale of the complete solutions
+        const int shift = forward_scale[d] + backward_scale - forward_scale[n];
+        for(const Counts& m: marginals)
+        for(int k = 0; k <= n; ++k)
+            mines[k*n + order[d]] += std::ldexp(m[k], shift);
+        //The completions of step d+1 are not needed anymore
+        Layer().swap(backward[d+1]);
+        backward_scale += p_rescale(backward[d]);
+    }
+
+    const Counts& all = forward[n][std::vector<int>()];
+    std::copy(all.begin(), all.end(), solutions.begin());
+}
+
+}
+
+ProbabilityEngine::ProbabilityEngine(const Minesweeper& ms, ThreadPool* pool, Cache* cache):
+    mGame(ms),
+    mPool(pool),
+    mProb(ms.cells(), 0.0),
+    mInteriorProb(0.0),
+    mOwnCache(cache ? nullptr : new Cache(cache_size)),
+    mCache(cache ? cache : mOwnCache.get()),
+    mComputed(false),
+    mResult(false),
+    mHash(0),
+    mMines(0),
+    mRows(0),
+    mCols(0)
+{}
+
+bool ProbabilityEngine::compute()
+{
+    //The probabilities only depend on the size of the field, the uncovered numbers and the
+    //number of mines. The game may have been reset or reshaped since, which clears the hash.
+    if(mComputed && mGame.hash() == mHash && mGame.mines() == mMines
+       && mGame.rows() == mRows && mGame.cols() == mCols && mGame.state() != Minesweeper::GameState::uninitialized)
+        return mResult;
+    mComputed = false;
+    mProb.resize(mGame.cells());
+
+    p_find_components();
+
+    p_enumerate_missing();
+
+    std::vector<const Distribution*> dists;
+    std::size_t frontier = 0;
+    for(const Component& c: mComponents)
+    {
+        dists.push_back(c.dist.get());
+        frontier += c.cells.size();
+    }
+
+    int covered = 0;
+    for(int i = 0; i < mGame.rows(); ++i)
+    for(int j = 0; j < mGame.cols(); ++j)
+        covered += !mGame.cell(i, j).visible();
+    const int interior = covered - frontier;
+    const int mines = mGame.mines();
+
+    //Distribution of the number of mines in all components
+    const std::size_t m = dists.size();
+    std::vector<const std::vector<double>*> solutions;
+    for(const Distribution* d: dists)
+        solutions.push_back(&d->solutions);
+    const std::vector<double> total = product(solutions, 0, m);
+
+    //Weight of K frontier mines: the number of ways to place the other mines in the interior.
+    //It is scaled relative to the most likely K and left at 0 where the frontier solutions
+    //are negligible, so that neither overflows nor underflows on huge fields.
+    std::vector<double> weight(total.size(), 0.0);
+    double max_log = -HUGE_VAL;
+    for(std::size_t k = 0; k < total.size(); ++k)
+    {
+        const int rest = mines - int(k);
+        if(rest >= 0 && rest <= interior && total[k] > DBL_MIN)
+            max_log = std::max(max_log, std::log(total[k]) + log_choose(interior, rest));
+    }
+    for(std::size_t k = 0; k < total.size(); ++k)
+    {
+        const int rest = mines - int(k);
+        if(rest >= 0 && rest <= interior && total[k] > DBL_MIN)
+            weight[k] = std::exp(log_choose(interior, rest) - max_log);
+    }
+
+    double norm = 0.0, interior_mines = 0.0;
+    for(std::size_t k = 0; k < total.size(); ++k)
+    {
+        norm += total[k] * weight[k];
+        interior_mines += total[k] * weight[k] * (mines - int(k));
+    }
+    mComputed = true;
+    mHash = mGame.hash();
+    mMines = mines;
+    mRows = mGame.rows();
+    mCols = mGame.cols();
+    mResult = norm > 0.0;
+    if(!mResult)
+        return false;
+    mInteriorProb = interior > 0 ? interior_mines / norm / interior : 0.0;
+
+    for(int i = 0; i < mGame.rows(); ++i)
+    for(int j = 0; j < mGame.cols(); ++j)
+        mProb[i*mGame.cols() + j] = mGame.cell(i, j).visible() ? 0.0 : mInteriorProb;
+
+    //Weight of the solutions of each component with k mines, summed over the other components
+    std::vector<std::vector<double>> weights(m);
+    if(m > 0)
+        weigh(solutions, 0, m, weight, weights);
+
+    for(std::size_t c = 0; c < m; ++c)
+    {
+        const Distribution& d = *dists[c];
+        const int n = mComponents[c].cells.size();
+        for(int x = 0; x < n; ++x)
+            mProb[mComponents[c].cells[x]] = 0.0;
+        for(int k = 0; k <= n; ++k)
+        {
+            const double w = weights[c][k];
+            if(w == 0.0)
+                continue;
+            for(int x = 0; x < n; ++x)
+                mProb[mComponents[c].cells[x]] += d.mines[k*n + x] * w / norm;
+        }
+    }
+    return true;
+}
+
+auto ProbabilityEngine::safest() const -> Position
+{
+    Position best(-1, -1);
+    double best_prob = 2.0;
+    for(int i = 0; i < mGame.rows(); ++i)
+    for(int j = 0; j < mGame.cols(); ++j)
+    {
+        if(!mGame.cell(i, j).visible() && probability(i, j) < best_prob)
+        {
+            best_prob = probability(i, j);
+            best = Position(i, j);
+        }
+    }
+    return best;
+}
+
+int ProbabilityEngine::p_find(int n)
+{
+    while(mParent[n] != n)
+        n = mParent[n] = mParent[mParent[n]];
+    return n;
+}
+
+void ProbabilityEngine::p_find_components()
+{
+    const int cols = mGame.cols();
+    mParent.assign(mGame.cells(), -1);
+    mComponents.clear();
+
+    //Link the covered neighbors of every number
+    for(int i = 0; i < mGame.rows(); ++i)
+    for(int j = 0; j < cols; ++j)
+    {
+        if(mGame.cell(i, j).adjacents() <= 0)
+            continue;
+        int first = -1;
+        mGame.for_each_nb_in_range(i, j, [&](int k, int l)
+        {
+            if(mGame.cell(k, l).visible())
+                return;
+            const int n = k*cols + l;
+            if(mParent[n] == -1)
+                mParent[n] = n;
+            if(first == -1)
+                first = n;
+            else
+                mParent[p_find(n)] = p_find(first);
+        });
+    }
+
+    //Collect the cells of each component in ascending order
+    std::vector<int> comp_of_root(mGame.cells(), -1);
+    for(int n = 0; n < int(mGame.cells()); ++n)
+    {
+        if(mParent[n] == -1)
+            continue;
+        int& comp = comp_of_root[p_find(n)];
+        if(comp == -1)
+        {
+            comp = mComponents.size();
+            mComponents.push_back(Component());
+        }
+        mComponents[comp].cells.push_back(n);
+    }
+    for(Component& c: mComponents)
+        c.key.assign(1, c.cells.size());
+
+    //Describe the numbers of each component
+    for(int i = 0; i < mGame.rows(); ++i)
+    for(int j = 0; j < cols; ++j)
+    {
+        if(mGame.cell(i, j).adjacents() <= 0)
+            continue;
+        Component* comp = nullptr;
+        std::size_t count_pos = 0;
+        mGame.for_each_nb_in_range(i, j, [&](int k, int l)
+        {
+            if(mGame.cell(k, l).visible())
+                return;
+            const int n = k*cols + l;
+            if(!comp)
+            {
+                comp = &mComponents[comp_of_root[p_find(n)]];
+                comp->key.push_back(mGame.cell(i, j).adjacents());
+                count_pos = comp->key.size();
+                comp->key.push_back(0);
+            }
+            comp->key.push_back(std::lower_bound(comp->cells.begin(), comp->cells.end(), n) - comp->cells.begin());
+            ++comp->key[count_pos];
+        });
+    }
+}
+
+void ProbabilityEngine::p_enumerate_missing()
+{
+    //Components which are not remembered, each one only once
+    std::map<std::vector<int>, std::size_t> task_of;
+    std::vector<const std::vector<int>*> keys;
+    std::vector<std::size_t> comp_task(mComponents.size());
+    for(std::size_t c = 0; c < mComponents.size(); ++c)
+    {
+        Component& comp = mComponents[c];
+        comp.hash = 0;
+        for(int x: comp.key)
+            comp.hash = splitmix64(comp.hash ^ std::uint32_t(x));
+        comp.dist = mCache->find(comp.hash);
+        //Another component may have the same hash
+        if(comp.dist && comp.dist->key == comp.key)
+            continue;
+        comp.dist.reset();
+        auto ins = task_of.insert(std::make_pair(comp.key, keys.size()));
+        if(ins.second)
+            keys.push_back(&ins.first->first);
+        comp_task[c] = ins.first->second;
+    }
+
+    std::vector<std::shared_ptr<const Distribution>> found(keys.size());
+    run_tasks(mPool, keys.size(), [this, &keys, &found](std::size_t t)
+    {
+        found[t] = std::make_shared<const Distribution>(p_enumerate(*keys[t], mPool));
+    });
+
+    for(std::size_t c = 0; c < mComponents.size(); ++c)
+    {
+        Component& comp = mComponents[c];
+        if(comp.dist)
+            continue;
+        comp.dist = found[comp_task[c]];
+        mCache->insert(comp.hash, comp.dist);
+    }
+}
+
+auto ProbabilityEngine::p_enumerate(const std::vector<int>& key, ThreadPool* pool) -> Distribution
+{
+    Enumerator e(key);
+    e.run(pool);
+
+    //Scale the counts to sum up to 1, which avoids overflows when combining many components
+    double sum = 0.0;
+    for(double s: e.solutions)
+        sum += s;
+    Distribution d;
+    d.key = key;
+    d.solutions.swap(e.solutions);
+    d.mines.swap(e.mines);
+    if(sum > 0.0)
+    {
+        for(double& s: d.solutions)
+            s /= sum;
+        for(double& s: d.mines)
+            s /= sum;
+    }
+    return d;
+}
@@ -0,0 +1,158 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROBABILITY_H_INCLUDED
+#define PROBABILITY_H_INCLUDED
+
+#include "minesweeper.h"
+#include "transposition_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+/** \brief Computes the exact mine probability of every covered cell
+ *
+ * The covered cells next to uncovered numbers (the frontier) are split into independent
+ * components, i.e. groups of cells which are not linked by any number. The mine
+ * assignments of each component which are consistent with the numbers are counted
+ * for each number of mines in the component, assigning one cell after another and
+ * memoizing on the partial sums of the numbers which are not complete yet.
+ * The components are then combined with the remaining covered cells (the interior),
+ * weighting each total number of frontier mines by the number of ways to place the
+ * remaining mines in the interior. The weights are computed in log space, so that
+ * huge fields do not overflow.
+ *
+ * The results of components are remembered in a TranspositionCache keyed by a hash of the
+ * component, so that a component which appears again after a move elsewhere on the field,
+ * or in another game sharing the cache, is not enumerated again. If the hash, the size and
+ * the number of mines of the game have not changed since the last compute(), the last
+ * probabilities are kept.
+ * Only the public interface of Minesweeper is used, and the player's flags are ignored.
+ *
+ * With a ThreadPool, the new components are counted in parallel, and so are the steps of
+ * large components. The results are the same for any number of threads.
+ */
+class ProbabilityEngine
+{
+public:
+    typedef Minesweeper::Position Position;
+
+    /** \brief Solution counts of a frontier component
+     *
+     * The counts are scaled so that they sum up to 1, as only their ratios matter.
+     */
+    struct Distribution
+    {
+        ///The component, see Component::key
+        std::vector<int> key;
+        ///Weight of the solutions with k mines
+        std::vector<double> solutions;
+        ///Weight of the solutions with k mines where cell c is a mine, at index k*cells + c
+        std::vector<double> mines;
+    };
+
+    ///Remembered distributions, which can be shared by engines in any number of threads
+    typedef TranspositionCache<Distribution> Cache;
+
+    /** \brief Creates an engine for the game \c ms, which has to outlive it
+     * \param pool Threads to use for the computation, or \c nullptr to compute in the calling thread.
+     * It has to outlive the engine.
+     * \param cache Cache to share with other engines, e.g. those of other games of the same kind,
+     * or \c nullptr for a cache of the engine's own. It has to outlive the engine.
+     */
+    explicit ProbabilityEngine(const Minesweeper& ms, ThreadPool* pool = nullptr, Cache* cache = nullptr);
+
+    /** \brief Computes the probabilities for the current state of the game
+     * \return \c false if the uncovered numbers contradict each other or the number of mines
+     */
+    bool compute();
+
+    /** \brief Returns the probability that the cell (\c i, \c j) contains a mine, as of the last compute()
+     *
+     * If the game has been reshaped since, compute() has to be called first.
+     */
+    double probability(int i, int j) const { return mProb[i*mGame.cols() + j]; }
+
+    ///Returns the mine probability of the covered cells which are not next to any number
+    double interior_probability() const { return mInteriorProb; }
+
+    ///Returns the covered cell with the lowest mine probability, or (-1, -1) if there is none
+    Position safest() const;
+
+    ///Returns the number of frontier components found by the last compute()
+    std::size_t components() const { return mComponents.size(); }
+
+    ///Forgets the remembered component results, including those of other engines sharing the cache
+    void clear_cache() { mCache->clear(); mComputed = false; }
+
+private:
+    ///A group of frontier cells linked by numbers
+    struct Component
+    {
+        ///The frontier cells, as indices into the field, in ascending order
+        std::vector<int> cells;
+        /** \brief Description of the component, independent of its position on the field
+         *
+         * The number of cells, followed by the value of each number, the count of
+         * its cells and their indices into \c cells.
+         */
+        std::vector<int> key;
+        ///Hash of \c key
+        std::uint64_t hash;
+        ///The solutions of the component, found by p_enumerate_missing()
+        std::shared_ptr<const Distribution> dist;
+    };
+
+    const Minesweeper& mGame;
+    ThreadPool* mPool;
+    std::vector<double> mProb;
+    double mInteriorProb;
+    std::vector<Component> mComponents;
+    ///Union-find parents of the frontier cells, or -1 for other cells
+    std::vector<int> mParent;
+    ///The cache of the engine if none is shared
+    std::unique_ptr<Cache> mOwnCache;
+    Cache* mCache;
+    ///Whether mProb and mInteriorProb hold the result of the last compute(), which returned mResult
+    bool mComputed;
+    bool mResult;
+    ///Hash, number of mines and size of the game at the last compute()
+    std::uint64_t mHash;
+    unsigned int mMines;
+    int mRows, mCols;
+
+    ///Number of slots of the engine's own cache
+    static const std::size_t cache_size = 4096;
+
+    int p_find(int n);
+    void p_find_components();
+
+    ///Looks up the distribution of every component, enumerating and remembering those which are missing
+    void p_enumerate_missing();
+
+    ///Enumerates the solutions of the component described by \c key
+    static Distribution p_enumerate(const std::vector<int>& key, ThreadPool* pool);
+};
+
+#endif
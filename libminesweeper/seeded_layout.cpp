@@ -0,0 +1,192 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "seeded_layout.h"
+#include "compact_minesweeper.h"
+#include "minesweeper.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+
+///Number of mines placed by one task of apply()
+const std::uint64_t mines_per_task = 1 << 16;
+///Number of cells tested by one task of apply() for a CompactMinesweeper
+const std::uint64_t cells_per_task = 1 << 20;
+
+}
+
+SeededLayout::SeededLayout(int rows, int cols, std::uint64_t mines, std::uint64_t id,
+                           int startr, int startc, bool safe_nbs):
+    mRows(rows), mCols(cols), mMines(mines), mId(id),
+    mNexcl(0)
+{
+    if(rows <= 0 || cols <= 0)
+        throw std::out_of_range("The number of rows and columns must be positive");
+    const std::uint64_t cells = std::uint64_t(rows) * cols;
+    if(mines >= cells)
+        throw std::out_of_range("The number of mines must be smaller than the number of cells");
+
+    //Same starting area as Minesweeper::sample_cells()
+    if(0 <= startr && startr < rows && 0 <= startc && startc < cols)
+    {
+        for(int i = startr-1; i <= startr+1; ++i)
+        for(int j = startc-1; j <= startc+1; ++j)
+        {
+            if(0 <= i && i < rows && 0 <= j && j < cols && (safe_nbs || (i == startr && j == startc)))
+                mExcluded[mNexcl++] = std::uint64_t(i)*cols + j;
+        }
+    }
+    mEligible = cells - mNexcl;
+    if(mines > mEligible)
+        throw std::out_of_range("The number of mines must be smaller than the number of cells outside the starting area");
+
+    //The smallest even number of bits covering the cells, so that cycle walking
+    //needs less than 4 steps on average
+    mHalfBits = 1;
+    while((std::uint64_t(1) << (2*mHalfBits)) < mEligible)
+        ++mHalfBits;
+
+    CounterRng rng(id);
+    for(std::uint64_t& key: mRoundKeys)
+        key = rng();
+}
+
+std::uint64_t SeededLayout::game_id(std::uint64_t seed, std::uint64_t game)
+{
+    return CounterRng(seed, game).at(0);
+}
+
+bool SeededLayout::mine(int i, int j) const
+{
+    const std::uint64_t n = std::uint64_t(i)*mCols + j;
+    //Skip the cells of the starting area before this one
+    std::uint64_t e = n;
+    for(unsigned int k = 0; k < mNexcl && mExcluded[k] <= n; ++k)
+    {
+        if(mExcluded[k] == n)
+            return false;
+        --e;
+    }
+    return p_permute(e) < mMines;
+}
+
+void SeededLayout::apply(Minesweeper& ms, ThreadPool* pool) const
+{
+    if(ms.state() != Minesweeper::GameState::uninitialized)
+        throw std::runtime_error("The field has already been initialized");
+    if(ms.rows() != mRows || ms.cols() != mCols)
+        throw std::invalid_argument("The size of the field does not match the layout");
+
+    //The mines are distinct cells, so the tasks write to different cells
+    const std::size_t tasks = (mMines + mines_per_task - 1) / mines_per_task;
+    auto place = [this, &ms](std::size_t t)
+    {
+        const std::uint64_t first = t * mines_per_task;
+        for_each_mine(first, std::min(mMines, first + mines_per_task), [&ms](int i, int j)
+        {
+            ms.cell(i, j).p_set_mine(true);
+        });
+    };
+    if(pool)
+        pool->run(tasks, place);
+    else
+    {
+        for(std::size_t t = 0; t < tasks; ++t)
+            place(t);
+    }
+    ms.init();
+}
+
+void SeededLayout::apply(CompactMinesweeper& ms, ThreadPool* pool) const
+{
+    if(ms.state() != Minesweeper::GameState::uninitialized)
+        throw std::runtime_error("The field has already been initialized");
+    if(ms.rows() != mRows || ms.cols() != mCols)
+        throw std::invalid_argument("The size of the field does not match the layout");
+
+    if(!pool)
+    {
+        for_each_mine(0, mMines, [&ms](int i, int j) { ms.p_set_mine(i, j, true); });
+        ms.init();
+        return;
+    }
+
+    //Bands of whole rows, so that the tasks write to different words of the bit planes
+    const int band = int(std::max<std::uint64_t>(1, cells_per_task / mCols));
+    const std::size_t tasks = (mRows + band - 1) / band;
+    pool->run(tasks, [this, &ms, band](std::size_t t)
+    {
+        const int last = int(std::min<std::uint64_t>(mRows, (t + 1) * band));
+        for(int i = t * band; i < last; ++i)
+        for(int j = 0; j < mCols; ++j)
+        {
+            if(mine(i, j))
+                ms.p_set_mine(i, j, true);
+        }
+    });
+    ms.init();
+}
+
+std::uint64_t SeededLayout::p_permute(std::uint64_t x) const
+{
+    const std::uint64_t mask = (std::uint64_t(1) << mHalfBits) - 1;
+    //Cycle walking: apply the permutation of the power of two range until x is in range again
+    do
+    {
+        std::uint64_t l = x >> mHalfBits, r = x & mask;
+        for(std::uint64_t key: mRoundKeys)
+        {
+            const std::uint64_t next = l ^ (splitmix64(key ^ r) & mask);
+            l = r;
+            r = next;
+        }
+        x = (l << mHalfBits) | r;
+    } while(x >= mEligible);
+    return x;
+}
+
+std::uint64_t SeededLayout::p_unpermute(std::uint64_t x) const
+{
+    const std::uint64_t mask = (std::uint64_t(1) << mHalfBits) - 1;
+    do
+    {
+        std::uint64_t l = x >> mHalfBits, r = x & mask;
+        for(int k = rounds - 1; k >= 0; --k)
+        {
+            const std::uint64_t prev = r ^ (splitmix64(mRoundKeys[k] ^ l) & mask);
+            r = l;
+            l = prev;
+        }
+        x = (l << mHalfBits) | r;
+    } while(x >= mEligible);
+    return x;
+}
+
+std::uint64_t SeededLayout::p_cell_of(std::uint64_t e) const
+{
+    for(unsigned int k = 0; k < mNexcl && mExcluded[k] <= e; ++k)
+        ++e;
+    return e;
+}
@@ -0,0 +1,168 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SEEDED_LAYOUT_H_INCLUDED
+#define SEEDED_LAYOUT_H_INCLUDED
+
+#include <cstdint>
+#include <limits>
+
+class CompactMinesweeper;
+class Minesweeper;
+class ThreadPool;
+
+///SplitMix64 finalizer, mixing the bits of \c x into a random looking value
+inline std::uint64_t splitmix64(std::uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/** \brief Counter-based random number generator
+ *
+ * The n-th value of stream \c stream of key \c key is a hash of the three, so any value can be
+ * computed without generating the ones before it, and independent streams are cheap to create.
+ * Satisfies the requirements of a uniform random bit generator, so it can be passed to
+ * Minesweeper::rand_init() and the standard distributions.
+ */
+class CounterRng
+{
+public:
+    typedef std::uint64_t result_type;
+
+    explicit CounterRng(std::uint64_t key, std::uint64_t stream = 0):
+        mKey(splitmix64(key) ^ splitmix64(stream + 0x5851F42D4C957F2Dull)), mCounter(0)
+    {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    ///Returns the next value
+    result_type operator()() { return at(mCounter++); }
+
+    ///Returns the n-th value of the stream
+    result_type at(std::uint64_t n) const { return splitmix64(mKey ^ splitmix64(n)); }
+
+    ///Continues the stream at the n-th value
+    void seek(std::uint64_t n) { mCounter = n; }
+
+private:
+    std::uint64_t mKey;
+    std::uint64_t mCounter;
+};
+
+/** \brief Mine layout which is a pure function of a 64 bit ID
+ *
+ * The cells outside of the starting area are shuffled by a keyed pseudo-random permutation
+ * (a Feistel network with cycle walking), and the cells which land in front of the
+ * permutation are mines. So whether a cell is a mine can be computed for any cell on
+ * its own, and any part of a field can be generated independently, in parallel and
+ * always with the same result. The number of mines is exact.
+ *
+ * The ID of game number \c game of a batch is game_id(seed, game), so a game can be
+ * reproduced from its ID alone.
+ */
+class SeededLayout
+{
+public:
+    /** \brief Creates the layout
+     * \param id The ID of the layout
+     * \param startr The row of the starting position
+     * \param startc The column of the starting position
+     * \param safe_nbs Whether the neighbors of the starting position are left open as well
+     * \throw std::out_of_range if the field size is invalid, mines >= rows*cols or if there
+     * are not enough cells outside of the starting area
+     */
+    SeededLayout(int rows, int cols, std::uint64_t mines, std::uint64_t id,
+                 int startr = -1, int startc = -1, bool safe_nbs = false);
+
+    ///Returns the ID of game number \c game of the batch with seed \c seed
+    static std::uint64_t game_id(std::uint64_t seed, std::uint64_t game);
+
+    int rows() const { return mRows; }
+    int cols() const { return mCols; }
+    std::uint64_t mines() const { return mMines; }
+    std::uint64_t id() const { return mId; }
+
+    ///Checks if there is a mine at (\c i, \c j)
+    bool mine(int i, int j) const;
+
+    /** \brief Calls \c f for the mines with number in [\c first, \c last), in no particular order
+     *
+     * The mines are numbered from 0 to mines() - 1, so that the mines can be split into
+     * ranges and generated in parallel. The work is proportional to the number of mines.
+     * f should have the following signature:
+     * \code void f(int i, int j) \endcode
+     */
+    template<class Func> void for_each_mine(std::uint64_t first, std::uint64_t last, Func f) const;
+
+    /** \brief Places the mines into the uninitialized game \c ms and initializes it
+     * \param pool Threads to use for placing the mines, or \c nullptr
+     * \throw std::runtime_error if \c ms is already initialized
+     * \throw std::invalid_argument if the size of \c ms is not the one of the layout
+     */
+    void apply(Minesweeper& ms, ThreadPool* pool = nullptr) const;
+
+    /** \brief Places the mines into the uninitialized game \c ms and initializes it
+     *
+     * This is the one for fields which are too large for Minesweeper. With a pool,
+     * the field is split into bands of rows and every cell is tested with mine(),
+     * so that no two tasks write to the same word.
+     * \sa apply(Minesweeper&, ThreadPool*)
+     */
+    void apply(CompactMinesweeper& ms, ThreadPool* pool = nullptr) const;
+
+private:
+    int mRows, mCols;
+    std::uint64_t mMines;
+    std::uint64_t mId;
+    ///Cells of the starting area as indices into the field, in ascending order
+    std::uint64_t mExcluded[9];
+    unsigned int mNexcl;
+    ///Number of cells outside of the starting area
+    std::uint64_t mEligible;
+    ///Number of rounds of the Feistel network. Fewer rounds give visibly uneven layouts on small fields.
+    static const int rounds = 6;
+
+    ///The permutation works on numbers of 2*mHalfBits bits
+    unsigned int mHalfBits;
+    std::uint64_t mRoundKeys[rounds];
+
+    ///The pseudo-random permutation of [0, mEligible) and its inverse
+    std::uint64_t p_permute(std::uint64_t x) const;
+    std::uint64_t p_unpermute(std::uint64_t x) const;
+
+    ///Maps an index in [0, mEligible) to the index of the corresponding cell of the field
+    std::uint64_t p_cell_of(std::uint64_t e) const;
+};
+
+template<class Func> void SeededLayout::for_each_mine(std::uint64_t first, std::uint64_t last, Func f) const
+{
+    for(std::uint64_t m = first; m < last; ++m)
+    {
+        const std::uint64_t n = p_cell_of(p_unpermute(m));
+        f(int(n / mCols), int(n % mCols));
+    }
+}
+
+#endif
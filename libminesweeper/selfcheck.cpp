@@ -0,0 +1,694 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Self-check of the parts of the library which restore or mirror a game.
+ *
+ * Random games are played with fixed seeds, and the results are compared cell by cell with
+ * what they have to be equal to. Every failed check is reported, and the exit status is 1
+ * if there has been any, so the program can run as a test.
+ */
+
+#include "batched_minesweeper.h"
+#include "compact_minesweeper.h"
+#include "concurrent_minesweeper.h"
+#include "fixed_minesweeper.h"
+#include "minesweeper.h"
+#include "minesweeper_pool.h"
+#include "move_journal.h"
+#include "probability.h"
+#include "seeded_layout.h"
+#include "snapshot.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+unsigned int failures = 0;
+///Number of calls of operator new, to check that FixedMinesweeper does not allocate
+std::atomic<std::size_t> allocations(0);
+
+///Reports \c what if \c ok is false
+void check(bool ok, const std::string& what)
+{
+    if(!ok)
+    {
+        ++failures;
+        std::cerr << "FAILED: " << what << '\n';
+    }
+}
+
+///Returns if the games \c a and \c b have the same cells, state and counts
+template<class A, class B> bool same_field(const A& a, const B& b)
+{
+    if(a.rows() != b.rows() || a.cols() != b.cols() || a.state() != b.state()
+       || a.covered() != b.covered() || a.hash() != b.hash())
+        return false;
+    for(int i = 0; i < a.rows(); ++i)
+    for(int j = 0; j < a.cols(); ++j)
+    {
+        const Minesweeper::CellEntry& x = a.cell(i, j);
+        const Minesweeper::CellEntry& y = b.cell(i, j);
+        if(x.visible() != y.visible() || x.flag() != y.flag() || x.p_mine() != y.p_mine()
+           || x.adjacents() != y.adjacents())
+            return false;
+    }
+    return true;
+}
+
+///Makes a random move on \c ms, or on the journal \c ms if it is one
+template<class Game> void random_move(Game& ms, int rows, int cols, std::mt19937& rng)
+{
+    const int i = rng() % rows, j = rng() % cols;
+    switch(rng() % 5)
+    {
+    case 0:
+        ms.uncover_if_unmarked(i, j);
+        break;
+    case 1:
+        ms.toggle_flag(i, j);
+        break;
+    case 2:
+        ms.chord(i, j);
+        break;
+    case 3:
+        ms.chord_all();
+        break;
+    default:
+        ms.click(i, j);
+        break;
+    }
+}
+
+///Starts the game \c ms with the layout \c id, uncovering the middle
+void start(Minesweeper& ms, unsigned int mines, std::uint64_t id)
+{
+    const int startr = ms.rows() / 2, startc = ms.cols() / 2;
+    ms.reset();
+    SeededLayout(ms.rows(), ms.cols(), mines, id, startr, startc, true).apply(ms);
+    ms.uncover(startr, startc);
+}
+
+///FixedMinesweeper plays like Minesweeper without allocating, and its copies do not share storage
+void check_fixed()
+{
+    for(unsigned int g = 0; g < 200; ++g)
+    {
+        std::mt19937 a(g), b(g), moves(g);
+        ExpertMinesweeper fixed;
+        Minesweeper ms(16, 30);
+        fixed.rand_init(99, a, 8, 15, true);
+        ms.rand_init(99, b, 8, 15, true);
+        fixed.uncover(8, 15);
+        ms.uncover(8, 15);
+        for(int k = 0; k < 100 && ms.running(); ++k)
+        {
+            std::mt19937 copy = moves;
+            random_move(ms, 16, 30, moves);
+            random_move(fixed, 16, 30, copy);
+        }
+        check(same_field(fixed, ms), "FixedMinesweeper plays like Minesweeper, game " + std::to_string(g));
+
+        ExpertMinesweeper other(fixed);
+        other.replay();
+        check(same_field(fixed, ms), "Replaying a copy of a FixedMinesweeper leaves the original alone, game " + std::to_string(g));
+        other = fixed;
+        check(same_field(other, ms), "An assigned FixedMinesweeper equals the original, game " + std::to_string(g));
+    }
+
+    std::mt19937 rng(1);
+    const std::size_t before = allocations;
+    {
+        ExpertMinesweeper fixed;
+        for(int g = 0; g < 20; ++g)
+        {
+            fixed.reset();
+            fixed.rand_init(99, rng, 8, 15, true);
+            fixed.uncover(8, 15);
+            for(int k = 0; k < 100 && fixed.running(); ++k)
+                random_move(fixed, 16, 30, rng);
+            ExpertMinesweeper copy(fixed);
+            copy.replay();
+        }
+    }
+    //The message of the check is allocated as well
+    const bool allocated = allocations != before;
+    check(!allocated, "FixedMinesweeper plays games without allocating");
+
+    //As a Minesweeper, it works with the classes built on top of it
+    ExpertMinesweeper fixed;
+    start(fixed, 99, 7);
+    const ExpertMinesweeper begin(fixed);
+    MoveJournal journal(fixed);
+    for(int k = 0; k < 80 && fixed.running(); ++k)
+        random_move(journal, 16, 30, rng);
+    const Minesweeper sliced(fixed);
+    while(journal.undo())
+        ;
+    check(same_field(fixed, begin), "Undoing the moves on a FixedMinesweeper restores it");
+    while(journal.redo())
+        ;
+    check(same_field(fixed, sliced), "A Minesweeper copied from a FixedMinesweeper keeps its own cells");
+
+    const std::string file = "selfcheck_fixed.snap";
+    Snapshot::save(fixed, file);
+    ExpertMinesweeper restored;
+    Snapshot(file).restore(restored);
+    std::remove(file.c_str());
+    check(same_field(restored, fixed), "A snapshot restores a FixedMinesweeper");
+
+    if(fixed.running())
+    {
+        ProbabilityEngine a(fixed), b(sliced);
+        bool same = a.compute() == b.compute();
+        for(int i = 0; i < 16; ++i)
+        for(int j = 0; j < 30; ++j)
+            same = same && a.probability(i, j) == b.probability(i, j);
+        check(same, "ProbabilityEngine sees a FixedMinesweeper like a Minesweeper");
+    }
+}
+
+///Uncovers all cells of \c ms without a mine
+void win(Minesweeper& ms)
+{
+    for(int i = 0; i < ms.rows(); ++i)
+    for(int j = 0; j < ms.cols(); ++j)
+    {
+        if(!ms.cell(i, j).p_mine())
+            ms.uncover(i, j);
+    }
+}
+
+///Returns if \c compact has the same cells, state and counts as \c ms
+bool same_cells(const CompactMinesweeper& compact, const Minesweeper& ms)
+{
+    if(compact.state() != ms.state() || compact.covered() != ms.covered() || compact.mines() != ms.mines())
+        return false;
+    for(int i = 0; i < ms.rows(); ++i)
+    for(int j = 0; j < ms.cols(); ++j)
+    {
+        const Minesweeper::CellEntry x = compact.cell(i, j);
+        const Minesweeper::CellEntry& y = ms.cell(i, j);
+        if(x.visible() != y.visible() || x.flag() != y.flag() || x.p_mine() != y.p_mine()
+           || x.adjacents() != y.adjacents() || x.p_adjacents() != y.p_adjacents())
+            return false;
+    }
+    return true;
+}
+
+///CompactMinesweeper plays like Minesweeper, also when its chord queue overflows
+void check_compact()
+{
+    //4096 cells, so the chord queue of CompactMinesweeper holds 1024 of them
+    const int rows = 64, cols = 64;
+    for(unsigned int g = 0; g < 100; ++g)
+    {
+        std::mt19937 a(g), b(g), rng(g);
+        Minesweeper ms(rows, cols);
+        CompactMinesweeper compact(rows, cols);
+        ms.rand_init(600, a, 32, 32, true);
+        compact.rand_init(600, b, 32, 32, true);
+        ms.uncover(32, 32);
+        compact.uncover(32, 32);
+
+        if(g % 2 == 0)
+        {
+            //Flagging every mine next to a large uncovered part queues far more than 1024 cells
+            for(int k = 0; k < 300; ++k)
+            {
+                const int i = rng() % rows, j = rng() % cols;
+                if(!ms.cell(i, j).p_mine())
+                {
+                    ms.uncover(i, j);
+                    compact.uncover(i, j);
+                }
+            }
+            for(int i = 0; i < rows; ++i)
+            for(int j = 0; j < cols; ++j)
+            {
+                ms.set_flag(i, j, ms.cell(i, j).p_mine());
+                compact.set_flag(i, j, ms.cell(i, j).p_mine());
+            }
+            const bool x = ms.chord_all(), y = compact.chord_all();
+            check(x == y && same_cells(compact, ms), "CompactMinesweeper chords like Minesweeper after its queue overflowed, game " + std::to_string(g));
+        }
+
+        for(int k = 0; k < 300 && ms.running(); ++k)
+        {
+            const int i = rng() % rows, j = rng() % cols;
+            switch(rng() % 5)
+            {
+            case 0:
+                ms.uncover_if_unmarked(i, j);
+                compact.uncover_if_unmarked(i, j);
+                break;
+            case 1:
+                ms.toggle_flag(i, j);
+                compact.set_flag(i, j, !compact.flagged(i, j));
+                break;
+            case 2:
+                ms.chord(i, j);
+                compact.chord(i, j);
+                break;
+            case 3:
+                ms.chord_all();
+                compact.chord_all();
+                break;
+            default:
+                ms.click(i, j);
+                compact.click(i, j);
+                break;
+            }
+        }
+        check(same_cells(compact, ms), "CompactMinesweeper plays like Minesweeper, game " + std::to_string(g));
+
+        ms.replay();
+        compact.replay();
+        check(same_cells(compact, ms), "CompactMinesweeper replays like Minesweeper, game " + std::to_string(g));
+    }
+}
+
+///Returns if the move \c m of BatchedMinesweeper would hit a mine on \c ms
+bool hits_mine(const Minesweeper& ms, const BatchedMinesweeper::Move& m)
+{
+    typedef BatchedMinesweeper::Action Action;
+    const Minesweeper::CellEntry& c = ms.cell(m.i, m.j);
+    if(m.action == Action::uncover || (m.action == Action::click && !c.visible() && !c.flag()))
+        return c.p_mine();
+    if(m.action != Action::chord && m.action != Action::click)
+        return false;
+    if(!c.visible())
+        return false;
+    int flags = 0;
+    bool mine = false;
+    ms.for_each_nb_in_range(m.i, m.j, [&](int k, int l)
+    {
+        flags += ms.cell(k, l).flag();
+        mine = mine || (!ms.cell(k, l).flag() && ms.cell(k, l).p_mine());
+    });
+    return flags == c.p_adjacents() && mine;
+}
+
+///BatchedMinesweeper plays each of its games like a Minesweeper
+void check_batched()
+{
+    typedef BatchedMinesweeper::Action Action;
+    const std::size_t games = 64;
+    BatchedMinesweeper batch(games, 16, 16);
+    std::vector<Minesweeper> ms(games, Minesweeper(16, 16));
+    for(std::size_t g = 0; g < games; ++g)
+    {
+        std::mt19937 a(g), b(g);
+        batch.rand_init(g, 40, a, 8, 8, true);
+        ms[g].rand_init(40, b, 8, 8, true);
+    }
+
+    std::mt19937 rng(64);
+    std::vector<BatchedMinesweeper::Move> moves(games);
+    std::vector<BatchedMinesweeper::Result> results;
+    std::vector<Minesweeper::Position> delta;
+    const Action actions[] = { Action::uncover, Action::chord, Action::click, Action::toggle_flag };
+    bool same = true;
+    for(int step = 0; step < 150; ++step)
+    {
+        for(std::size_t g = 0; g < games; ++g)
+        {
+            BatchedMinesweeper::Move& m = moves[g];
+            m.i = step == 0 ? 8 : rng() % 16;
+            m.j = step == 0 ? 8 : rng() % 16;
+            m.action = step == 0 ? Action::uncover : actions[rng() % 4];
+        }
+        std::vector<Minesweeper::GameState> expected(games);
+        std::vector<std::size_t> uncovered(games, 0);
+        for(std::size_t g = 0; g < games; ++g)
+        {
+            const BatchedMinesweeper::Move& m = moves[g];
+            expected[g] = ms[g].state();
+            if(!ms[g].running())
+                continue;
+            //A move which hits a mine loses the game, even if it would also win it
+            const bool hit = hits_mine(ms[g], m);
+            delta.clear();
+            switch(m.action)
+            {
+            case Action::uncover:
+                ms[g].uncover(m.i, m.j, delta);
+                break;
+            case Action::chord:
+                ms[g].chord(m.i, m.j, delta);
+                break;
+            case Action::click:
+                ms[g].click(m.i, m.j, delta);
+                break;
+            default:
+                ms[g].toggle_flag(m.i, m.j);
+                break;
+            }
+            uncovered[g] = delta.size();
+            expected[g] = hit ? Minesweeper::GameState::loss : ms[g].state();
+        }
+        batch.step(moves, results);
+
+        for(std::size_t g = 0; g < games; ++g)
+        {
+            same = same && results[g].state == expected[g] && batch.state(g) == expected[g]
+                && results[g].uncovered == uncovered[g] && batch.covered(g) == ms[g].covered();
+            for(int i = 0; i < 16; ++i)
+            for(int j = 0; j < 16; ++j)
+            {
+                const Minesweeper::CellEntry& c = ms[g].cell(i, j);
+                same = same && batch.visible(g, i, j) == c.visible() && batch.flagged(g, i, j) == c.flag()
+                    && batch.adjacents(g, i, j) == c.adjacents() && batch.p_mine(g, i, j) == c.p_mine();
+            }
+        }
+    }
+    check(same, "BatchedMinesweeper plays like Minesweeper");
+
+    //A chord with a wrong flag which hits the mine and uncovers the last covered cell loses,
+    //while Minesweeper ends with the state set last, here a win
+    BatchedMinesweeper one(1, 2, 3);
+    one.p_set_mine(0, 0, 2, true);
+    one.init();
+    const BatchedMinesweeper::Move last[] = { {0, 0, Action::uncover}, {0, 0, Action::toggle_flag}, {1, 1, Action::chord} };
+    for(const BatchedMinesweeper::Move& m: last)
+        one.step(std::vector<BatchedMinesweeper::Move>(1, m), results);
+    check(results[0].state == Minesweeper::GameState::loss && results[0].uncovered == 1 && one.covered(0) == 0,
+          "BatchedMinesweeper loses a move which hits a mine and uncovers the last cell");
+}
+
+///ConcurrentMinesweeper played by several threads ends like Minesweeper given the same clicks
+void check_concurrent()
+{
+    const int rows = 32, cols = 32;
+    const unsigned int threads = 4;
+    for(unsigned int g = 0; g < 50; ++g)
+    {
+        Minesweeper ms(rows, cols);
+        start(ms, 150, g);
+        ConcurrentMinesweeper concurrent(ms);
+
+        //Only cells without a mine are clicked, so the result does not depend on the order
+        std::mt19937 rng(g);
+        std::vector<Minesweeper::Position> clicks;
+        while(clicks.size() < (g % 5 == 0 ? ms.cells() : 200))
+        {
+            const int i = rng() % rows, j = rng() % cols;
+            if(!ms.cell(i, j).p_mine())
+                clicks.emplace_back(i, j);
+        }
+
+        std::vector<std::thread> workers;
+        for(unsigned int t = 0; t < threads; ++t)
+            workers.emplace_back([&concurrent, &clicks, t, threads]()
+            {
+                for(std::size_t k = t; k < clicks.size(); k += threads)
+                    concurrent.click(clicks[k].first, clicks[k].second);
+            });
+        for(std::thread& w: workers)
+            w.join();
+        for(const Minesweeper::Position& p: clicks)
+            ms.click(p.first, p.second);
+
+        bool same = concurrent.state() == ms.state() && concurrent.covered() == ms.covered();
+        for(int i = 0; i < rows; ++i)
+        for(int j = 0; j < cols; ++j)
+        {
+            const Minesweeper::CellEntry x = concurrent.cell(i, j);
+            const Minesweeper::CellEntry& y = ms.cell(i, j);
+            same = same && x.visible() == y.visible() && x.flag() == y.flag() && x.p_mine() == y.p_mine()
+                && x.adjacents() == y.adjacents();
+        }
+        check(same, "ConcurrentMinesweeper played by " + std::to_string(threads) + " threads ends like Minesweeper, game " + std::to_string(g));
+    }
+}
+
+///Cells changed with the cheating functions are covered again by replay() and reset()
+void check_edits()
+{
+    for(unsigned int g = 0; g < 200; ++g)
+    {
+        std::mt19937 rng(g);
+        Minesweeper ms(9, 9), played(9, 9);
+        start(ms, 10, g);
+        start(played, 10, g);
+        //Uncovering numbered cells directly has to look like uncovering them by moves
+        for(int k = 0; k < 8 && played.running(); ++k)
+        {
+            const int i = rng() % 9, j = rng() % 9;
+            if(played.cell(i, j).p_mine() || played.cell(i, j).p_adjacents() == 0)
+                continue;
+            played.uncover(i, j);
+            if(played.running())
+                ms.p_set_visible(i, j, true);
+        }
+        if(played.running())
+        {
+            ms.chord_all();
+            played.chord_all();
+            check(same_field(ms, played), "Cells uncovered with p_set_visible() count like played ones, game " + std::to_string(g));
+        }
+
+        ms.p_set_mine(0, 0, true);
+        ms.p_set_visible(8, 8, true);
+        ms.replay();
+        bool covered = ms.hash() == 0;
+        for(int i = 0; i < 9; ++i)
+        for(int j = 0; j < 9; ++j)
+            covered = covered && !ms.cell(i, j).visible() && !ms.cell(i, j).flag();
+        check(covered, "replay() covers the cells uncovered with p_set_visible(), game " + std::to_string(g));
+
+        ms.reset();
+        Minesweeper fresh(9, 9);
+        start(ms, 10, g + 1000);
+        start(fresh, 10, g + 1000);
+        check(same_field(ms, fresh), "reset() clears the cells changed with p_set_mine() and p_set_visible(), game " + std::to_string(g));
+    }
+
+    //A mine placed before init() and a cell uncovered after it must not outlive reset()
+    Minesweeper ms(9, 9);
+    ms.cell(4, 4).p_set_mine(true);
+    ms.init();
+    ms.p_set_visible(0, 0, true);
+    ms.reset();
+    SeededLayout(9, 9, 10, 1, 8, 8, true).apply(ms);
+    check(!ms.cell(0, 0).visible() || ms.cell(0, 0).p_mine(), "reset() covers a cell uncovered with p_set_visible()");
+    win(ms);
+    check(ms.state() == Minesweeper::GameState::win, "A game after reset() can be won");
+}
+
+///Undoing the moves of a MoveJournal restores every earlier field, and redoing them the later ones
+void check_journal()
+{
+    for(unsigned int g = 0; g < 200; ++g)
+    {
+        std::mt19937 rng(g);
+        Minesweeper ms(16, 30);
+        start(ms, 99, g);
+        MoveJournal journal(ms);
+        //The field before each move, and the one after the last
+        std::vector<Minesweeper> fields(1, ms);
+        for(int k = 0; k < 80 && ms.running(); ++k)
+        {
+            random_move(journal, 16, 30, rng);
+            fields.push_back(ms);
+        }
+
+        bool ok = true;
+        for(std::size_t m = fields.size() - 1; m-- > 0; )
+            ok = journal.undo() && same_field(ms, fields[m]) && ok;
+        check(ok && !journal.can_undo(), "Undoing every move restores each earlier field, game " + std::to_string(g));
+
+        ok = true;
+        for(std::size_t m = 1; m < fields.size(); ++m)
+            ok = journal.redo() && same_field(ms, fields[m]) && ok;
+        check(ok && !journal.can_redo(), "Redoing every move restores each later field, game " + std::to_string(g));
+
+        //Continuing after undoing half of the moves has to work like on a fresh copy
+        const std::size_t half = fields.size() / 2;
+        while(journal.moves() > half - 1)
+            journal.undo();
+        Minesweeper copy = fields[half - 1];
+        std::mt19937 a(g + 1000), b(g + 1000);
+        for(int k = 0; k < 20; ++k)
+        {
+            random_move(journal, 16, 30, a);
+            random_move(copy, 16, 30, b);
+        }
+        check(same_field(ms, copy), "Moves after an undo play like on a copy, game " + std::to_string(g));
+    }
+}
+
+///The hash only depends on the uncovered numbers and flags, and shared engine caches give the same results
+void check_hash()
+{
+    ProbabilityEngine::Cache cache(256);
+    for(unsigned int g = 0; g < 200; ++g)
+    {
+        std::mt19937 rng(g);
+        Minesweeper ms(16, 30);
+        start(ms, 99, g);
+        for(int k = 0; k < 60 && ms.running(); ++k)
+            random_move(ms, 16, 30, rng);
+
+        //Reach the same view in another order: the uncovered cells backwards, then the flags
+        Minesweeper other(ms);
+        other.replay();
+        check(other.hash() == 0, "A replayed game has the hash 0, game " + std::to_string(g));
+        for(int i = 15; i >= 0; --i)
+        for(int j = 29; j >= 0; --j)
+        {
+            if(ms.cell(i, j).visible())
+                other.uncover(i, j);
+        }
+        for(int i = 0; i < 16; ++i)
+        for(int j = 0; j < 30; ++j)
+            other.set_flag(i, j, ms.cell(i, j).flag());
+        check(other.hash() == ms.hash(), "The hash does not depend on the order of the moves, game " + std::to_string(g));
+
+        other.toggle_flag(0, 0);
+        check(other.hash() != ms.hash(), "A flag changes the hash, game " + std::to_string(g));
+        other.toggle_flag(0, 0);
+        check(other.hash() == ms.hash(), "Taking a flag back restores the hash, game " + std::to_string(g));
+
+        if(ms.running())
+        {
+            ProbabilityEngine shared(ms, nullptr, &cache), own(ms);
+            const bool a = shared.compute(), b = own.compute();
+            bool same = a == b && shared.compute() == a;
+            for(int i = 0; i < 16; ++i)
+            for(int j = 0; j < 30; ++j)
+                same = same && shared.probability(i, j) == own.probability(i, j);
+            check(same, "An engine with a shared cache computes the same probabilities, game " + std::to_string(g));
+        }
+    }
+
+    //An engine must not keep the probabilities of a game which has been reshaped since
+    MinesweeperPool pool(1);
+    MinesweeperPool::Handle game = pool.acquire(9, 9);
+    start(*game, 10, 1);
+    game->replay();
+    ProbabilityEngine engine(*game);
+    engine.compute();
+    game.reset();
+    game = pool.acquire(16, 30);
+    start(*game, 99, 2);
+    game->replay();
+    ProbabilityEngine fresh(*game);
+    const bool a = engine.compute(), b = fresh.compute();
+    bool same = a == b;
+    for(int i = 0; i < 16; ++i)
+    for(int j = 0; j < 30; ++j)
+        same = same && engine.probability(i, j) == fresh.probability(i, j);
+    check(same, "An engine computes again after its game has been reshaped");
+}
+
+///Snapshot::restore() reproduces the saved field, and snapshots with wrong counts are rejected
+void check_snapshot()
+{
+    const std::string file = "selfcheck.snap";
+    Minesweeper ms(13, 37), restored(13, 37);
+    for(unsigned int g = 0; g < 200; ++g)
+    {
+        std::mt19937 rng(g);
+        if(g % 10 == 0)
+            ms.reset();
+        else
+        {
+            start(ms, 80, g);
+            for(int k = 0; k < int(g % 50) && ms.running(); ++k)
+                random_move(ms, 13, 37, rng);
+            //Some games are finished on purpose, to cover the other states
+            if(g % 7 == 0)
+                win(ms);
+        }
+        Snapshot::save(ms, file);
+        Snapshot(file).restore(restored);
+        check(ms.state() == Minesweeper::GameState::uninitialized ? restored.state() == ms.state() : same_field(restored, ms),
+              "A restored snapshot equals the saved game, game " + std::to_string(g));
+    }
+
+    //The covered count follows the magic, the version and five 32 bit fields in the header
+    std::string data;
+    {
+        std::ifstream is(file, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    data[32] ^= 1;
+    std::ofstream(file, std::ios::binary) << data;
+    bool rejected = false;
+    try
+    {
+        Snapshot snap(file);
+    }
+    catch(std::runtime_error&)
+    {
+        rejected = true;
+    }
+    check(rejected, "A snapshot whose covered count disagrees with its planes is rejected");
+    std::remove(file.c_str());
+}
+
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if(void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+int main()
+{
+    check_fixed();
+    check_edits();
+    check_batched();
+    check_compact();
+    check_concurrent();
+    check_snapshot();
+    check_journal();
+    check_hash();
+
+    if(failures > 0)
+    {
+        std::cerr << failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "All checks passed\n";
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "snapshot.h"
+
+#include <bitset>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MS_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char Snapshot::magic[8] = {'M', 'S', 'W', 'P', 'S', 'N', 'A', 'P'};
+
+void Snapshot::save(const Minesweeper& ms, std::ostream& os)
+{
+    const std::uint64_t cells = std::uint64_t(ms.rows()) * ms.cols();
+    const std::uint64_t words = (cells + 63) / 64;
+    std::vector<std::uint64_t> mines(words, 0), visible(words, 0), flags(words, 0);
+    std::uint64_t covered = 0;
+    for(int i = 0; i < ms.rows(); ++i)
+    for(int j = 0; j < ms.cols(); ++j)
+    {
+        const std::uint64_t n = std::uint64_t(i)*ms.cols() + j;
+        const std::uint64_t bit = std::uint64_t(1) << (n % 64);
+        const Minesweeper::CellEntry& c = ms.cell(i, j);
+        if(c.p_mine())
+            mines[n / 64] |= bit;
+        if(c.visible())
+            visible[n / 64] |= bit;
+        if(c.flag())
+            flags[n / 64] |= bit;
+        covered += !c.visible() && !c.p_mine();
+    }
+
+    Header h;
+    std::memset(&h, 0, sizeof h);
+    std::memcpy(h.magic, magic, sizeof magic);
+    h.version = version;
+    h.byte_order = 0x01020304;
+    h.rows = ms.rows();
+    h.cols = ms.cols();
+    h.state = std::uint32_t(ms.state());
+    h.covered = covered;
+    h.mines = ms.state() == Minesweeper::GameState::uninitialized ? 0 : ms.mines();
+    h.words = words;
+    os.write(reinterpret_cast<const char*>(&h), sizeof h);
+    for(const std::vector<std::uint64_t>* plane: {&mines, &visible, &flags})
+        os.write(reinterpret_cast<const char*>(plane->data()), words * sizeof(std::uint64_t));
+}
+
+void Snapshot::save(const Minesweeper& ms, const std::string& file)
+{
+    std::ofstream os(file, std::ios::binary);
+    save(ms, os);
+    os.flush();
+    if(!os)
+        throw std::runtime_error("Could not write " + file);
+}
+
+Snapshot::Snapshot(const std::string& file):
+    mMap(nullptr),
+    mSize(0)
+{
+#ifdef MS_HAVE_MMAP
+    const int fd = ::open(file.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("Could not open " + file);
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || st.st_size < off_t(sizeof(Header)))
+    {
+        ::close(fd);
+        throw std::runtime_error(file + " is not a snapshot");
+    }
+    mSize = st.st_size;
+    mMap = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(mMap == MAP_FAILED)
+    {
+        mMap = nullptr;
+        throw std::runtime_error("Could not map " + file);
+    }
+    mHeader = static_cast<const Header*>(mMap);
+#else
+    std::ifstream is(file, std::ios::binary | std::ios::ate);
+    if(!is)
+        throw std::runtime_error("Could not open " + file);
+    mSize = is.tellg();
+    mBuffer.resize((mSize + 7) / 8);
+    is.seekg(0);
+    if(mSize < sizeof(Header) || !is.read(reinterpret_cast<char*>(mBuffer.data()), mSize))
+        throw std::runtime_error(file + " is not a snapshot");
+    mHeader = reinterpret_cast<const Header*>(mBuffer.data());
+#endif
+
+    try
+    {
+        p_validate(file);
+    }
+    catch(...)
+    {
+#ifdef MS_HAVE_MMAP
+        ::munmap(mMap, mSize);
+#endif
+        throw;
+    }
+}
+
+Snapshot::~Snapshot()
+{
+#ifdef MS_HAVE_MMAP
+    ::munmap(mMap, mSize);
+#endif
+}
+
+template<class Func> void Snapshot::p_for_each_bit(const std::uint64_t* plane, Func f) const
+{
+    for(std::uint64_t w = 0; w < mHeader->words; ++w)
+    {
+        for(std::uint64_t bits = plane[w]; bits; bits &= bits - 1)
+        {
+            const std::uint64_t n = w*64 + std::bitset<64>((bits & -bits) - 1).count();
+            f(int(n / mHeader->cols), int(n % mHeader->cols));
+        }
+    }
+}
+
+void Snapshot::restore(Minesweeper& ms) const
+{
+    if(ms.rows() != rows() || ms.cols() != cols())
+        throw std::invalid_argument("The size of the field does not match the snapshot");
+
+    ms.reset();
+    if(state() == Minesweeper::GameState::uninitialized)
+        return;
+
+    p_for_each_bit(mMines, [&ms](int i, int j) { ms.cell(i, j).p_set_mine(true); });
+    ms.init();
+    p_for_each_bit(mVisible, [&ms](int i, int j) { ms.p_set_visible(i, j, true); });
+    p_for_each_bit(mFlags, [&ms](int i, int j) { ms.set_flag(i, j, true); });
+    //p_validate() has checked that the covered count agrees with the planes
+    ms.mState = state();
+}
+
+void Snapshot::p_validate(const std::string& file)
+{
+    if(std::memcmp(mHeader->magic, magic, sizeof magic) != 0)
+        throw std::runtime_error(file + " is not a snapshot");
+    if(mHeader->version != version)
+        throw std::runtime_error(file + " has an unsupported snapshot version");
+    if(mHeader->byte_order != 0x01020304)
+        throw std::runtime_error(file + " has been written on a machine of different byte order");
+    const std::uint64_t cells = std::uint64_t(mHeader->rows) * mHeader->cols;
+    if(mHeader->rows == 0 || mHeader->cols == 0 || mHeader->words != (cells + 63) / 64
+       || mHeader->state > std::uint32_t(Minesweeper::GameState::loss)
+       || mSize < sizeof(Header) + 3 * mHeader->words * sizeof(std::uint64_t))
+        throw std::runtime_error(file + " is not a valid snapshot");
+
+    const std::uint64_t* planes = reinterpret_cast<const std::uint64_t*>(mHeader + 1);
+    mMines = planes;
+    mVisible = planes + mHeader->words;
+    mFlags = planes + 2 * mHeader->words;
+
+    //The counts in the header have to agree with the planes, otherwise the restored game
+    //could end at once or never. Bits beyond the last cell would address cells outside of the field.
+    const std::uint64_t last = cells % 64 == 0 ? ~std::uint64_t(0) : (std::uint64_t(1) << (cells % 64)) - 1;
+    std::uint64_t mines = 0, visible = 0;
+    bool valid = true;
+    for(std::uint64_t w = 0; w < mHeader->words; ++w)
+    {
+        const std::uint64_t mask = w + 1 == mHeader->words ? last : ~std::uint64_t(0);
+        valid = valid && !((mMines[w] | mVisible[w] | mFlags[w]) & ~mask) && !(mMines[w] & mVisible[w]);
+        mines += std::bitset<64>(mMines[w]).count();
+        visible += std::bitset<64>(mVisible[w]).count();
+    }
+    const Minesweeper::GameState st = state();
+    if(st != Minesweeper::GameState::uninitialized)
+    {
+        valid = valid && mHeader->mines == mines && mHeader->covered == cells - mines - visible
+             && (mHeader->covered == 0) == (st == Minesweeper::GameState::win);
+    }
+    if(!valid)
+        throw std::runtime_error(file + " is not a valid snapshot");
+}
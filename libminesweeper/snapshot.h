@@ -0,0 +1,126 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SNAPSHOT_H_INCLUDED
+#define SNAPSHOT_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/** \brief Binary snapshot of a game
+ *
+ * The file consists of a header with the format version, the field size, the state and the
+ * number of covered cells, followed by three bitplanes: mines, uncovered cells and flags.
+ * Bit n of a plane belongs to the cell (n / cols, n % cols), and the planes are stored as
+ * 64 bit words in native byte order, each starting at a multiple of 8 bytes.
+ *
+ * Loading maps the file into memory and accesses the planes in place. Opening a snapshot reads
+ * the planes once to check that they agree with the header. restore() resets the game, places
+ * the mines, calls Minesweeper::init() and then uncovers and flags the cells of the set bits
+ * one by one. init() visits every cell, so restore() takes O(cells) time plus the set bits.
+ */
+class Snapshot
+{
+public:
+    ///Version of the format written by save()
+    static const std::uint32_t version = 1;
+
+    ///Writes the game \c ms to \c os
+    static void save(const Minesweeper& ms, std::ostream& os);
+
+    /** \brief Writes the game \c ms to the file \c file
+     * \throw std::runtime_error if the file cannot be written
+     */
+    static void save(const Minesweeper& ms, const std::string& file);
+
+    /** \brief Opens the snapshot in the file \c file
+     * \throw std::runtime_error if the file cannot be read or is not a valid snapshot
+     */
+    explicit Snapshot(const std::string& file);
+    ~Snapshot();
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    int rows() const { return mHeader->rows; }
+    int cols() const { return mHeader->cols; }
+    Minesweeper::GameState state() const { return Minesweeper::GameState(mHeader->state); }
+    ///Returns the number of covered cells without a mine
+    std::uint64_t covered() const { return mHeader->covered; }
+    std::uint64_t mines() const { return mHeader->mines; }
+
+    bool mine(int i, int j) const { return p_bit(mMines, i, j); }
+    bool visible(int i, int j) const { return p_bit(mVisible, i, j); }
+    bool flag(int i, int j) const { return p_bit(mFlags, i, j); }
+
+    /** \brief Restores the snapshot into \c ms
+     * \throw std::invalid_argument if the size of \c ms is not the one of the snapshot
+     */
+    void restore(Minesweeper& ms) const;
+
+private:
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        ///Written as 0x01020304, to detect snapshots from machines of different byte order
+        std::uint32_t byte_order;
+        std::uint32_t rows;
+        std::uint32_t cols;
+        std::uint32_t state;
+        std::uint32_t reserved;
+        std::uint64_t covered;
+        std::uint64_t mines;
+        ///Number of words of each plane
+        std::uint64_t words;
+    };
+
+    static const char magic[8];
+
+    ///The mapped file, or nullptr if it has been read into mBuffer
+    void* mMap;
+    std::size_t mSize;
+    std::vector<std::uint64_t> mBuffer;
+
+    const Header* mHeader;
+    const std::uint64_t* mMines;
+    const std::uint64_t* mVisible;
+    const std::uint64_t* mFlags;
+
+    bool p_bit(const std::uint64_t* plane, int i, int j) const
+    {
+        const std::uint64_t n = std::uint64_t(i)*mHeader->cols + j;
+        return plane[n / 64] >> (n % 64) & 1;
+    }
+
+    ///Checks the header and the planes and sets the plane pointers
+    void p_validate(const std::string& file);
+
+    ///Calls \c f(i, j) for the cell of each set bit of \c plane. Only the set bits are visited.
+    template<class Func> void p_for_each_bit(const std::uint64_t* plane, Func f) const;
+};
+
+#endif
@@ -0,0 +1,199 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "solver.h"
+
+#include <algorithm>
+
+Solver::Solver(const Minesweeper& ms):
+    mGame(ms)
+{
+    mKnown.reserve(ms.cells());
+    mQueue.reserve(ms.cells());
+    mQueued.reserve(ms.cells());
+    reset();
+}
+
+void Solver::reset()
+{
+    mKnown.assign(mGame.cells(), unknown);
+    mQueued.assign(mGame.cells(), false);
+    mQueue.clear();
+    mSafe.clear();
+    mMines.clear();
+    for(int i = 0; i < mGame.rows(); ++i)
+    for(int j = 0; j < mGame.cols(); ++j)
+    {
+        if(mGame.cell(i, j).visible())
+            mKnown[index(i, j)] = safe;
+        p_queue(i, j);
+    }
+}
+
+void Solver::update(const std::vector<Position>& delta)
+{
+    for(const Position& p: delta)
+        update(p.first, p.second);
+}
+
+void Solver::update(int i, int j)
+{
+    mKnown[index(i, j)] = safe;
+    p_queue_around(i, j);
+}
+
+bool Solver::solve()
+{
+    mSafe.clear();
+    mMines.clear();
+    while(!mQueue.empty())
+    {
+        const int n = mQueue.back();
+        mQueue.pop_back();
+        mQueued[n] = false;
+        p_examine(n / mGame.cols(), n % mGame.cols());
+    }
+    return !mSafe.empty() || !mMines.empty();
+}
+
+bool Solver::known_safe(int i, int j) const
+{
+    return mKnown[index(i, j)] == safe;
+}
+
+bool Solver::known_mine(int i, int j) const
+{
+    return mKnown[index(i, j)] == mine;
+}
+
+void Solver::p_queue(int i, int j)
+{
+    const int n = index(i, j);
+    if(mQueued[n] || mGame.cell(i, j).adjacents() <= 0)
+        return;
+    mQueued[n] = true;
+    mQueue.push_back(n);
+}
+
+void Solver::p_queue_around(int i, int j)
+{
+    p_queue(i, j);
+    mGame.for_each_nb_in_range(i, j, [this](int k, int l) { p_queue(k, l); });
+}
+
+bool Solver::p_constraint(int i, int j, Constraint& c) const
+{
+    c.size = 0;
+    c.mines = mGame.cell(i, j).adjacents();
+    mGame.for_each_nb_in_range(i, j, [this, &c](int k, int l)
+    {
+        const int n = index(k, l);
+        if(mKnown[n] == mine)
+            --c.mines;
+        else if(mKnown[n] == unknown && !mGame.cell(k, l).visible())
+            c.cells[c.size++] = n;
+    });
+    //Keep the cells sorted so that constraints can be compared by merging
+    std::sort(c.cells, c.cells + c.size);
+    return c.size > 0;
+}
+
+void Solver::p_examine(int i, int j)
+{
+    Constraint a;
+    if(!p_constraint(i, j, a))
+        return;
+
+    //Single cell rule
+    if(a.mines == 0 || a.mines == a.size)
+    {
+        const Knowledge what = a.mines == 0 ? safe : mine;
+        for(int k = 0; k < a.size; ++k)
+            p_learn(a.cells[k], what);
+        return;
+    }
+
+    //Pair rule with the numbers which can share covered neighbors, i.e. those at most 2 cells away
+    for(int k = std::max(i-2, 0); k <= std::min(i+2, mGame.rows()-1); ++k)
+    for(int l = std::max(j-2, 0); l <= std::min(j+2, mGame.cols()-1); ++l)
+    {
+        Constraint b;
+        if((k == i && l == j) || mGame.cell(k, l).adjacents() <= 0 || !p_constraint(k, l, b))
+            continue;
+
+        //Split the cells into those only around a, only around b, and shared ones
+        int only_a[8], only_b[8];
+        int na = 0, nb = 0, shared = 0;
+        int x = 0, y = 0;
+        while(x < a.size || y < b.size)
+        {
+            if(y == b.size || (x < a.size && a.cells[x] < b.cells[y]))
+                only_a[na++] = a.cells[x++];
+            else if(x == a.size || b.cells[y] < a.cells[x])
+                only_b[nb++] = b.cells[y++];
+            else
+            {
+                ++shared;
+                ++x;
+                ++y;
+            }
+        }
+        if(shared == 0)
+            continue;
+
+        //If a needs more mines than b can provide in the shared cells, the rest are all mines
+        //around a, and b's own cells are safe. And vice versa.
+        const int* mines_in = nullptr;
+        const int* safe_in = nullptr;
+        int nmines = 0, nsafe = 0;
+        if(a.mines - b.mines == na && (na > 0 || nb > 0))
+        {
+            mines_in = only_a; nmines = na;
+            safe_in = only_b; nsafe = nb;
+        }
+        else if(b.mines - a.mines == nb && (na > 0 || nb > 0))
+        {
+            mines_in = only_b; nmines = nb;
+            safe_in = only_a; nsafe = na;
+        }
+        else
+            continue;
+
+        for(int m = 0; m < nmines; ++m)
+            p_learn(mines_in[m], mine);
+        for(int s = 0; s < nsafe; ++s)
+            p_learn(safe_in[s], safe);
+        //The constraint of (i, j) has changed and has been queued again by p_learn()
+        return;
+    }
+}
+
+void Solver::p_learn(int n, Knowledge what)
+{
+    if(mKnown[n] != unknown)
+        return;
+    mKnown[n] = what;
+    const int i = n / mGame.cols(), j = n % mGame.cols();
+    if(what == safe)
+        mSafe.emplace_back(i, j);
+    else
+        mMines.emplace_back(i, j);
+    mGame.for_each_nb_in_range(i, j, [this](int k, int l) { p_queue(k, l); });
+}
@@ -0,0 +1,124 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOLVER_H_INCLUDED
+#define SOLVER_H_INCLUDED
+
+#include "minesweeper.h"
+
+#include <vector>
+
+/** \brief Finds safe cells and mines by logical deduction
+ *
+ * The solver looks at the uncovered numbered cells next to covered ones (the frontier)
+ * and applies two rules: the single cell rule (a number which is already satisfied,
+ * or which needs all its covered neighbors as mines) and the pair rule (comparing the
+ * covered neighbors of two nearby numbers, which includes the subset rule).
+ * It only uses the public interface of Minesweeper and ignores the player's flags.
+ *
+ * The solver is incremental: after a move, update() is told which cells have been
+ * uncovered and only the numbers around them are examined again.
+ * All memory is reserved in the constructor, so solve() does not allocate
+ * unless the result vectors have to grow.
+ */
+class Solver
+{
+public:
+    typedef Minesweeper::Position Position;
+
+    ///Creates a solver for the game \c ms, which has to outlive it
+    explicit Solver(const Minesweeper& ms);
+
+    /** \brief Forgets everything deduced so far and examines the whole field again
+     *
+     * This has to be called after the game has been replayed or reset.
+     */
+    void reset();
+
+    ///Tells the solver that the cells in \c delta have been uncovered
+    void update(const std::vector<Position>& delta);
+
+    ///Tells the solver that the cell (\c i, \c j) has been uncovered
+    void update(int i, int j);
+
+    /** \brief Deduces as much as possible from the numbers examined since the last call
+     * \return \c true if new safe cells or mines have been found
+     *
+     * The cells found by this call are available through safe_cells() and mine_cells().
+     */
+    bool solve();
+
+    ///Returns the covered cells which have been found to be safe by the last solve()
+    const std::vector<Position>& safe_cells() const { return mSafe; }
+    ///Returns the cells which have been found to be mines by the last solve()
+    const std::vector<Position>& mine_cells() const { return mMines; }
+
+    ///Returns if the cell (\c i, \c j) is known to be safe, including uncovered cells
+    bool known_safe(int i, int j) const;
+    ///Returns if the cell (\c i, \c j) is known to contain a mine
+    bool known_mine(int i, int j) const;
+
+private:
+    ///What the solver knows about a cell
+    enum Knowledge : char
+    {
+        unknown,
+        safe,
+        mine
+    };
+
+    ///The covered cells of unknown content around a number, and how many mines are among them
+    struct Constraint
+    {
+        int cells[8];
+        int size;
+        int mines;
+    };
+
+    const Minesweeper& mGame;
+    std::vector<Knowledge> mKnown;
+    ///Numbers which have to be examined
+    std::vector<int> mQueue;
+    ///Whether a cell is in mQueue
+    std::vector<char> mQueued;
+    std::vector<Position> mSafe;
+    std::vector<Position> mMines;
+
+    int index(int i, int j) const { return i*mGame.cols() + j; }
+
+    ///Adds the cell (\c i, \c j) to the queue if it is an uncovered number
+    void p_queue(int i, int j);
+
+    ///Queues the cell (\c i, \c j) and its neighbors
+    void p_queue_around(int i, int j);
+
+    /** \brief Computes the constraint of the number at (\c i, \c j)
+     * \return \c false if there are no covered cells of unknown content around it
+     */
+    bool p_constraint(int i, int j, Constraint& c) const;
+
+    ///Applies the rules to the number at (\c i, \c j)
+    void p_examine(int i, int j);
+
+    ///Marks the cell \c n as \c what and queues the numbers around it
+    void p_learn(int n, Knowledge what);
+};
+
+#endif
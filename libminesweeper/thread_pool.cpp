@@ -0,0 +1,167 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace
+{
+
+///The pool whose worker is the current thread, if any
+thread_local const ThreadPool* current_pool = nullptr;
+///The index of the current worker in its pool
+thread_local unsigned int current_index = 0;
+
+}
+
+ThreadPool::ThreadPool(unsigned int threads):
+    mPending(0),
+    mStop(false)
+{
+    if(threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for(unsigned int t = 0; t < threads; ++t)
+        mQueues.emplace_back(new Queue);
+    for(unsigned int t = 0; t + 1 < threads; ++t)
+        mWorkers.emplace_back(&ThreadPool::p_work, this, t);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> l(mSleepLock);
+        mStop = true;
+    }
+    mWake.notify_all();
+    for(std::thread& w: mWorkers)
+        w.join();
+}
+
+void ThreadPool::p_submit(Batch& batch, std::vector<std::function<void()>>& funcs)
+{
+    const unsigned int self = p_self();
+    const bool worker = self < mWorkers.size();
+    mPending += funcs.size();
+    for(std::size_t t = 0; t < funcs.size(); ++t)
+    {
+        //A worker keeps its tasks for itself until they are stolen, other threads spread them
+        Queue& q = *mQueues[worker ? self : t % mQueues.size()];
+        std::lock_guard<std::mutex> l(q.lock);
+        q.tasks.push_back(Task{std::move(funcs[t]), &batch});
+    }
+    {
+        std::lock_guard<std::mutex> l(mSleepLock);
+    }
+    mWake.notify_all();
+}
+
+void ThreadPool::p_wait(Batch& batch)
+{
+    const unsigned int self = p_self();
+    Task task;
+    while(batch.left > 0)
+    {
+        if(p_take(self, task))
+            p_execute(task);
+        else
+        {
+            std::unique_lock<std::mutex> l(mSleepLock);
+            mWake.wait(l, [this, &batch]() { return batch.left == 0 || mPending > 0; });
+        }
+    }
+}
+
+void ThreadPool::p_work(unsigned int self)
+{
+    current_pool = this;
+    current_index = self;
+    Task task;
+    while(true)
+    {
+        if(p_take(self, task))
+            p_execute(task);
+        else
+        {
+            std::unique_lock<std::mutex> l(mSleepLock);
+            mWake.wait(l, [this]() { return mStop || mPending > 0; });
+            if(mStop && mPending == 0)
+                return;
+        }
+    }
+}
+
+bool ThreadPool::p_take(unsigned int self, Task& task)
+{
+    {
+        Queue& q = *mQueues[self];
+        std::lock_guard<std::mutex> l(q.lock);
+        if(!q.tasks.empty())
+        {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            --mPending;
+            return true;
+        }
+    }
+    for(std::size_t k = 1; k < mQueues.size(); ++k)
+    {
+        Queue& q = *mQueues[(self + k) % mQueues.size()];
+        std::lock_guard<std::mutex> l(q.lock);
+        if(!q.tasks.empty())
+        {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            --mPending;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::p_execute(Task& task)
+{
+    Batch& batch = *task.batch;
+    try
+    {
+        task.func();
+    }
+    catch(...)
+    {
+        std::lock_guard<std::mutex> l(batch.lock);
+        if(!batch.error)
+            batch.error = std::current_exception();
+    }
+    task.func = nullptr;
+    //The batch may be gone as soon as the last task is counted
+    if(--batch.left == 0)
+    {
+        {
+            std::lock_guard<std::mutex> l(mSleepLock);
+        }
+        mWake.notify_all();
+    }
+}
+
+unsigned int ThreadPool::p_self() const
+{
+    return current_pool == this ? current_index : mQueues.size() - 1;
+}
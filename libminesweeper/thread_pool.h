@@ -0,0 +1,135 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef THREAD_POOL_H_INCLUDED
+#define THREAD_POOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** \brief Work-stealing pool of threads
+ *
+ * Every worker has its own queue of tasks. It takes new tasks from the back of its own
+ * queue and, when that is empty, steals from the front of the other queues, so that
+ * unevenly sized tasks are balanced between the threads.
+ *
+ * The thread which calls run() helps to execute tasks until its batch is done, so run()
+ * may also be called from within a task without deadlocking. Tasks must not depend on
+ * the order in which they are executed; callers which need deterministic results write
+ * them into slots indexed by the task and combine them in that order.
+ */
+class ThreadPool
+{
+public:
+    /** \brief Starts the pool
+     * \param threads Number of threads executing tasks, including the one calling run().
+     * 0 means one per hardware thread.
+     */
+    explicit ThreadPool(unsigned int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ///Returns the number of threads executing tasks, including the one calling run()
+    unsigned int size() const { return mWorkers.size() + 1; }
+
+    /** \brief Calls f(t) for every t in [0, count) and waits until all calls are done
+     *
+     * If a call throws, the first exception is rethrown once all calls are done.
+     */
+    template<class Func> void run(std::size_t count, Func f);
+
+private:
+    ///Tasks started by one call to run()
+    struct Batch
+    {
+        std::atomic<std::size_t> left;
+        std::mutex lock;
+        std::exception_ptr error;
+    };
+
+    struct Task
+    {
+        std::function<void()> func;
+        Batch* batch;
+    };
+
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    ///One queue per worker, followed by the one for other threads
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::vector<std::thread> mWorkers;
+    ///Number of tasks in all queues
+    std::atomic<std::size_t> mPending;
+    std::mutex mSleepLock;
+    std::condition_variable mWake;
+    bool mStop;
+
+    void p_submit(Batch& batch, std::vector<std::function<void()>>& funcs);
+    void p_wait(Batch& batch);
+    void p_work(unsigned int self);
+
+    ///Takes a task, preferring the queue \c self
+    bool p_take(unsigned int self, Task& task);
+    void p_execute(Task& task);
+
+    ///Returns the queue of the calling thread
+    unsigned int p_self() const;
+};
+
+template<class Func> void ThreadPool::run(std::size_t count, Func f)
+{
+    if(count == 0)
+        return;
+    if(mWorkers.empty())
+    {
+        for(std::size_t t = 0; t < count; ++t)
+            f(t);
+        return;
+    }
+
+    std::vector<std::function<void()>> funcs;
+    funcs.reserve(count);
+    for(std::size_t t = 0; t < count; ++t)
+        funcs.push_back([&f, t]() { f(t); });
+
+    Batch batch;
+    batch.left = count;
+    p_submit(batch, funcs);
+    p_wait(batch);
+    if(batch.error)
+        std::rethrow_exception(batch.error);
+}
+
+#endif
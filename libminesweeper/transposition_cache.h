@@ -0,0 +1,139 @@
+/*
+    libminesweeper
+    Copyright (C) 2014 ljfa-ag
+
+    This file is part of libminesweeper.
+
+    libminesweeper is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libminesweeper is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libminesweeper.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TRANSPOSITION_CACHE_H_INCLUDED
+#define TRANSPOSITION_CACHE_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/** \brief Bounded map from 64-bit hashes to results, shared between threads
+ *
+ * Meant for solvers which meet the same subproblem again, in later moves or in other games,
+ * e.g. the frontier components of ProbabilityEngine. The cache has a fixed number of slots
+ * and each hash has one slot, so finding and remembering a result takes constant time.
+ * A new result replaces the one in its slot, which keeps the memory bounded without any
+ * bookkeeping of the age of the results.
+ *
+ * Different subproblems can have the same hash, so the results should contain enough to
+ * tell whether they belong to the subproblem at hand. The results are shared and immutable,
+ * so a result found by one thread stays valid while another thread replaces it.
+ * The slots are protected by a fixed set of locks, so threads rarely wait for each other.
+ */
+template<class Value> class TranspositionCache
+{
+public:
+    /** \brief Creates an empty cache
+     * \param capacity Number of slots, which is rounded up to a power of two
+     */
+    explicit TranspositionCache(std::size_t capacity = 4096);
+
+    TranspositionCache(const TranspositionCache&) = delete;
+    TranspositionCache& operator=(const TranspositionCache&) = delete;
+
+    ///Returns the result remembered for \c hash, or \c nullptr
+    std::shared_ptr<const Value> find(std::uint64_t hash) const;
+
+    ///Remembers \c value for \c hash, replacing the result in its slot
+    void insert(std::uint64_t hash, std::shared_ptr<const Value> value);
+
+    ///Forgets all results
+    void clear();
+
+    ///Returns the number of slots
+    std::size_t capacity() const { return mSlots.size(); }
+
+    ///Returns the number of calls to find() which have found a result
+    std::uint64_t hits() const { return mHits; }
+    ///Returns the number of calls to find() which have not found a result
+    std::uint64_t misses() const { return mMisses; }
+
+private:
+    struct Slot
+    {
+        std::uint64_t hash;
+        std::shared_ptr<const Value> value;
+    };
+
+    std::vector<Slot> mSlots;
+    ///Slot s is protected by mLocks[s % locks]
+    mutable std::unique_ptr<std::mutex[]> mLocks;
+    mutable std::atomic<std::uint64_t> mHits;
+    mutable std::atomic<std::uint64_t> mMisses;
+
+    static const std::size_t locks = 64;
+
+    std::size_t p_slot(std::uint64_t hash) const { return hash & (mSlots.size() - 1); }
+};
+
+template<class Value> TranspositionCache<Value>::TranspositionCache(std::size_t capacity):
+    mLocks(new std::mutex[locks]),
+    mHits(0),
+    mMisses(0)
+{
+    std::size_t size = 1;
+    while(size < capacity)
+        size *= 2;
+    mSlots.resize(size, Slot{0, nullptr});
+}
+
+template<class Value> std::shared_ptr<const Value> TranspositionCache<Value>::find(std::uint64_t hash) const
+{
+    const std::size_t s = p_slot(hash);
+    std::shared_ptr<const Value> res;
+    {
+        std::lock_guard<std::mutex> guard(mLocks[s % locks]);
+        if(mSlots[s].hash == hash)
+            res = mSlots[s].value;
+    }
+    ++(res ? mHits : mMisses);
+    return res;
+}
+
+template<class Value> void TranspositionCache<Value>::insert(std::uint64_t hash, std::shared_ptr<const Value> value)
+{
+    const std::size_t s = p_slot(hash);
+    std::lock_guard<std::mutex> guard(mLocks[s % locks]);
+    mSlots[s].hash = hash;
+    //The old result is released by the caller's copy of the argument, outside of the lock
+    mSlots[s].value.swap(value);
+}
+
+template<class Value> void TranspositionCache<Value>::clear()
+{
+    for(std::size_t s = 0; s < mSlots.size(); ++s)
+    {
+        std::shared_ptr<const Value> old;
+        {
+            std::lock_guard<std::mutex> guard(mLocks[s % locks]);
+            mSlots[s].value.swap(old);
+        }
+    }
+    mHits = 0;
+    mMisses = 0;
+}
+
+#endif